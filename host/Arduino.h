@@ -0,0 +1,73 @@
+#ifndef ARDUINO_H
+#define ARDUINO_H
+
+
+/* The part of Arduino core used by driver_st7920, clock_face and benchmark_st7920,
+   so that they compile on a desktop against the emulator.
+   Time is the simulated time of the emulator, delays advance it instead of waiting. */
+
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdio.h>
+
+
+#define F_CPU 16000000UL // the simulated board is still a Nano
+#define clockCyclesPerMicrosecond() (F_CPU / 1000000UL)
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+// Program memory is ordinary memory on a desktop.
+#define PROGMEM
+#define PGM_P const char *
+#define pgm_read_byte(address) (*(const uint8_t *)(address))
+#define pgm_read_word(address) (*(const uint16_t *)(address))
+#define pgm_read_dword(address) (*(const uint32_t *)(address))
+#define pgm_read_ptr(address) (*(void *const *)(address))
+#define strlen_P strlen
+#define strnlen_P strnlen
+#define memcpy_P memcpy
+
+class __FlashStringHelper;
+#define F(text) ((const __FlashStringHelper *)(text))
+
+#define _BV(bit) (1 << (bit))
+#define min(a, b) ((a) < (b) ? (a) : (b))
+#define max(a, b) ((a) > (b) ? (a) : (b))
+
+#define DEC 10
+#define HEX 16
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+
+
+// Serial output goes to stdout.
+class Print {
+public:
+  size_t print(const char *text);
+  size_t print(const __FlashStringHelper *text);
+  size_t print(char character);
+  size_t print(int number, int base = DEC);
+  size_t print(unsigned int number, int base = DEC);
+  size_t print(long number, int base = DEC);
+  size_t print(unsigned long number, int base = DEC);
+  size_t println();
+  template <typename T> size_t println(T value) { return print(value) + println(); }
+  template <typename T> size_t println(T value, int base) { return print(value, base) + println(); }
+};
+
+class HardwareSerial : public Print {
+public:
+  void begin(unsigned long) {}
+  int available() { return 0; }
+  int read() { return -1; }
+};
+
+extern HardwareSerial Serial;
+
+#endif
@@ -0,0 +1,6 @@
+#ifndef SPI_H
+#define SPI_H
+
+// Included by driver_st7920.cpp, the host build uses EXTERNAL_TRANSPORT_ST7920 instead of SPI.
+
+#endif
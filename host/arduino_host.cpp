@@ -0,0 +1,72 @@
+#include <Arduino.h>
+#include "driver_st7920.h"
+#include "emulator_st7920.h"
+
+
+HardwareSerial Serial;
+
+
+unsigned long millis() {
+  return nanoseconds_Emulator() / 1000000;
+}
+
+
+unsigned long micros() {
+  return nanoseconds_Emulator() / 1000;
+}
+
+
+void delay(unsigned long ms) {
+  delay_Emulator(ms * 1000);
+}
+
+
+void delayMicroseconds(unsigned int us) {
+  delay_Emulator(us);
+}
+
+
+void transferByteExternal_ST7920(byte data) {
+  receiveByte_Emulator(data);
+}
+
+
+size_t Print::print(const char *text) {
+  return fputs(text, stdout) < 0 ? 0 : strlen(text);
+}
+
+
+size_t Print::print(const __FlashStringHelper *text) {
+  return print((const char *)text);
+}
+
+
+size_t Print::print(char character) {
+  return fputc(character, stdout) == EOF ? 0 : 1;
+}
+
+
+size_t Print::print(int number, int base) {
+  return print((long)number, base);
+}
+
+
+size_t Print::print(unsigned int number, int base) {
+  return print((unsigned long)number, base);
+}
+
+
+size_t Print::print(long number, int base) {
+  if (base == HEX) return printf("%lX", (unsigned long)number);
+  return printf("%ld", number);
+}
+
+
+size_t Print::print(unsigned long number, int base) {
+  return printf(base == HEX ? "%lX" : "%lu", number);
+}
+
+
+size_t Print::println() {
+  return print('\n');
+}
@@ -0,0 +1,328 @@
+#include <string.h>
+#include "emulator_st7920.h"
+
+
+#define ROWS_EMULATOR 64 // controller rows, each of 256 pixels
+#define WORDS_EMULATOR 16 // GDRAM words in a controller row
+#define SHORT_EXECUTION_EMULATOR 72000 // ns, all instructions and data writes
+#define LONG_EXECUTION_EMULATOR 1600000 // ns, display clear and return home in basic set
+
+// Controller state, names follow the datasheet.
+static unsigned short width_Emulator;
+static uint64_t byteTime_Emulator; // ns to clock in 8 bits
+static uint64_t now_Emulator; // ns
+static uint64_t busyUntil_Emulator; // ns
+static Counters_Emulator counters_Emulator;
+static FILE *recording_Emulator = NULL;
+
+static uint16_t ddram_Emulator[64]; // 4 lines of 16 cells, a cell is 2 bytes
+static uint16_t cgram_Emulator[64]; // 4 glyphs of 16 rows
+static uint16_t gdram_Emulator[ROWS_EMULATOR][WORDS_EMULATOR];
+
+static bool re_Emulator; // extended instruction set
+static bool g_Emulator; // graphic display on
+static bool sr_Emulator; // 1 - scroll address enabled, 0 - CGRAM address enabled
+static bool increment_Emulator; // I/D of entry mode
+static bool display_Emulator; // D of display control
+static uint8_t scroll_Emulator; // vertical scroll address
+static uint8_t reversed_Emulator; // bit n - controller line n is reversed
+
+enum Target_Emulator {DDRAM_EMULATOR, CGRAM_EMULATOR, GDRAM_EMULATOR};
+static Target_Emulator target_Emulator; // RAM written by data
+static uint8_t address_Emulator; // address counter (GDRAM: horizontal word)
+static uint8_t vertical_Emulator; // GDRAM vertical address
+static bool verticalSet_Emulator; // true - the next GDRAM address is horizontal
+static bool secondByte_Emulator; // true - the next data byte is the low byte of a word
+static uint8_t firstByte_Emulator;
+
+// Serial protocol decoder.
+static bool synchronized_Emulator;
+static bool rs_Emulator;
+static bool lowNibble_Emulator; // true - the next byte holds DB3-DB0
+static uint8_t highNibble_Emulator;
+
+
+void initialize_Emulator(unsigned short width, unsigned long clock) {
+  width_Emulator = width;
+  byteTime_Emulator = (8000000000ULL + clock - 1) / clock; // rounded up, never kinder than the real bus
+  now_Emulator = 0;
+  busyUntil_Emulator = 0;
+  memset(&counters_Emulator, 0, sizeof(counters_Emulator));
+
+  // DDRAM content is undefined at power on, spaces make it visible as blank.
+  for (uint8_t i = 0; i < 64; i++) ddram_Emulator[i] = 0x2020;
+  memset(cgram_Emulator, 0, sizeof(cgram_Emulator));
+  memset(gdram_Emulator, 0, sizeof(gdram_Emulator));
+
+  re_Emulator = false;
+  g_Emulator = false;
+  sr_Emulator = false;
+  increment_Emulator = true;
+  display_Emulator = false;
+  scroll_Emulator = 0;
+  reversed_Emulator = 0;
+  target_Emulator = DDRAM_EMULATOR;
+  address_Emulator = 0;
+  vertical_Emulator = 0;
+  verticalSet_Emulator = false;
+  secondByte_Emulator = false;
+  synchronized_Emulator = false;
+  lowNibble_Emulator = false;
+}
+
+
+static void executeBasic_Emulator(uint8_t instruction) {
+  if (instruction & 0b10000000) { // set DDRAM address
+    target_Emulator = DDRAM_EMULATOR;
+    address_Emulator = instruction & 0b00111111;
+    secondByte_Emulator = false;
+  } else if (instruction & 0b01000000) { // set CGRAM address
+    if (sr_Emulator) counters_Emulator.protocolErrors += 1; // needs SR = 0
+    target_Emulator = CGRAM_EMULATOR;
+    address_Emulator = instruction & 0b00111111;
+    secondByte_Emulator = false;
+  } else if (instruction & 0b00100000) { // function set
+    re_Emulator = instruction & 0b00000100;
+  } else if (instruction & 0b00010000) { // cursor or display shift, only cursor moves are modelled
+    if (!(instruction & 0b00001000)) address_Emulator = (address_Emulator + (instruction & 0b00000100 ? 1 : -1)) & 63;
+  } else if (instruction & 0b00001000) { // display control
+    display_Emulator = instruction & 0b00000100;
+  } else if (instruction & 0b00000100) { // entry mode
+    increment_Emulator = instruction & 0b00000010;
+  } else if (instruction & 0b00000010) { // return home
+    target_Emulator = DDRAM_EMULATOR;
+    address_Emulator = 0;
+    secondByte_Emulator = false;
+  } else if (instruction & 0b00000001) { // display clear
+    for (uint8_t i = 0; i < 64; i++) ddram_Emulator[i] = 0x2020;
+    target_Emulator = DDRAM_EMULATOR;
+    address_Emulator = 0;
+    secondByte_Emulator = false;
+    increment_Emulator = true;
+  }
+}
+
+
+static void executeExtended_Emulator(uint8_t instruction) {
+  if (instruction & 0b10000000) { // set GDRAM address, vertical first then horizontal
+    if (!verticalSet_Emulator) {
+      vertical_Emulator = instruction & 0b00111111;
+      verticalSet_Emulator = true;
+    } else {
+      address_Emulator = instruction & 0b00001111;
+      verticalSet_Emulator = false;
+      target_Emulator = GDRAM_EMULATOR;
+      secondByte_Emulator = false;
+    }
+  } else if (instruction & 0b01000000) { // set scroll address (SR = 1) or IRAM address
+    if (sr_Emulator) scroll_Emulator = instruction & 0b00111111;
+  } else if (instruction & 0b00100000) { // function set, G only changes while RE is already 1
+    g_Emulator = instruction & 0b00000010;
+    re_Emulator = instruction & 0b00000100;
+  } else if (instruction & 0b00011000) { // sleep, the content is kept
+  } else if (instruction & 0b00000100) { // reverse, each instruction toggles the line
+    reversed_Emulator ^= 1 << (instruction & 0b00000011);
+  } else if (instruction & 0b00000010) { // vertical scroll or RAM address select
+    sr_Emulator = instruction & 0b00000001;
+  }
+  // standby (0b00000001) keeps the content as well
+}
+
+
+static void writeData_Emulator(uint8_t data) {
+  counters_Emulator.dataWrites += 1;
+  if (!secondByte_Emulator) {
+    firstByte_Emulator = data;
+    secondByte_Emulator = true;
+    return;
+  }
+  secondByte_Emulator = false;
+  uint16_t word = firstByte_Emulator << 8 | data;
+
+  switch (target_Emulator) {
+    case DDRAM_EMULATOR:
+      ddram_Emulator[address_Emulator] = word;
+      address_Emulator = (address_Emulator + (increment_Emulator ? 1 : -1)) & 63;
+      break;
+    case CGRAM_EMULATOR:
+      cgram_Emulator[address_Emulator] = word;
+      address_Emulator = (address_Emulator + 1) & 63;
+      break;
+    case GDRAM_EMULATOR:
+      gdram_Emulator[vertical_Emulator][address_Emulator] = word;
+      address_Emulator = (address_Emulator + 1) & (WORDS_EMULATOR - 1); // stays in the same row
+      break;
+  }
+}
+
+
+// Run a decoded instruction or data byte, it starts executing when its last bit arrives.
+static void execute_Emulator(bool rs, uint8_t value) {
+  if (now_Emulator < busyUntil_Emulator) counters_Emulator.violations += 1;
+  bool longExecution = !rs && !re_Emulator && (value == 0b00000001 || (value & 0b11111110) == 0b00000010);
+  busyUntil_Emulator = now_Emulator + (longExecution ? LONG_EXECUTION_EMULATOR : SHORT_EXECUTION_EMULATOR);
+
+  if (rs) {
+    writeData_Emulator(value);
+    return;
+  }
+  counters_Emulator.instructions += 1;
+  if (!(value & 0b10000000)) verticalSet_Emulator = false; // any other instruction restarts GDRAM addressing
+  if (re_Emulator) executeExtended_Emulator(value);
+  else executeBasic_Emulator(value);
+}
+
+
+/* Synchronizing byte is 1 1 1 1 1 RW RS 0, so its low nibble is never 0,
+   while the nibble bytes DBx DBx DBx DBx 0 0 0 0 always have a low nibble of 0. */
+void receiveByte_Emulator(uint8_t data) {
+  if (recording_Emulator) fprintf(recording_Emulator, "%llu %02X\n", (unsigned long long)now_Emulator, data);
+  now_Emulator += byteTime_Emulator;
+  counters_Emulator.bytes += 1;
+
+  if (data & 0b00001111) {
+    synchronized_Emulator = (data & 0b11111001) == 0b11111000 && !(data & 0b00000100); // reads are unsupported
+    if (!synchronized_Emulator) counters_Emulator.protocolErrors += 1;
+    rs_Emulator = data & 0b00000010;
+    lowNibble_Emulator = false;
+    return;
+  }
+  if (!synchronized_Emulator) {
+    counters_Emulator.protocolErrors += 1;
+    return;
+  }
+  if (!lowNibble_Emulator) {
+    highNibble_Emulator = data;
+    lowNibble_Emulator = true;
+    return;
+  }
+  lowNibble_Emulator = false;
+  execute_Emulator(rs_Emulator, highNibble_Emulator | data >> 4);
+}
+
+
+void delay_Emulator(unsigned long us) {
+  now_Emulator += us * 1000ULL;
+}
+
+
+uint64_t nanoseconds_Emulator() {
+  return now_Emulator;
+}
+
+
+uint64_t idleNanoseconds_Emulator() {
+  return busyUntil_Emulator > now_Emulator ? busyUntil_Emulator : now_Emulator;
+}
+
+
+const Counters_Emulator *getCounters_Emulator() {
+  return &counters_Emulator;
+}
+
+
+// Outline of a ROM character cell that isn't modelled.
+static bool placeholder_Emulator(uint8_t x, uint8_t y, uint8_t width) {
+  if (y < 1 || y > 14 || x < 1 || x > width - 2) return false;
+  return y == 1 || y == 14 || x == 1 || x == width - 2;
+}
+
+
+// Pixel of text layer at controller row (0-63) and column (0-255).
+static bool textPixel_Emulator(uint8_t row, uint8_t column) {
+  uint16_t word = ddram_Emulator[row / 16 * 16 + column / 16];
+  uint8_t high = word >> 8, low = word;
+  uint8_t x = column % 16, y = row % 16;
+
+  if (high == 0x00 && low % 2 == 0 && low <= 6) return cgram_Emulator[low / 2 * 16 + y] >> (15 - x) & 1;
+  if (high >= 0xA1) return placeholder_Emulator(x, y, 16);
+  uint8_t code = x < 8 ? high : low;
+  return code != ' ' && placeholder_Emulator(x % 8, y, 8);
+}
+
+
+static bool controllerPixel_Emulator(uint8_t row, uint8_t column) {
+  bool pixel = textPixel_Emulator(row, column);
+  if (g_Emulator && (gdram_Emulator[row][column / 16] >> (15 - column % 16) & 1)) pixel = true;
+  if (reversed_Emulator & 1 << (row / 16)) pixel = !pixel;
+  return pixel;
+}
+
+
+/* 128*64: panel rows 0-31 are the left half of controller rows, 32-63 the right half.
+   256*64: panel rows are controller rows. Vertical scroll moves the first controller row shown. */
+static void locate_Emulator(uint8_t x, uint8_t y, uint8_t *row, uint8_t *column) {
+  if (width_Emulator == 128) {
+    *row = (y % 32 + scroll_Emulator) % ROWS_EMULATOR;
+    *column = x + (y >= 32 ? 128 : 0);
+  } else {
+    *row = (y + scroll_Emulator) % ROWS_EMULATOR;
+    *column = x;
+  }
+}
+
+
+void render_Emulator(uint8_t pixels[]) {
+  for (uint8_t y = 0; y < 64; y++)
+    for (unsigned short x = 0; x < width_Emulator; x++) {
+      uint8_t row, column;
+      locate_Emulator(x, y, &row, &column);
+      pixels[y * width_Emulator + x] = display_Emulator && controllerPixel_Emulator(row, column);
+    }
+}
+
+
+bool writeImage_Emulator(const char *path, uint8_t scale) {
+  static uint8_t pixels[64 * 256];
+  render_Emulator(pixels);
+
+  FILE *file = fopen(path, "wb");
+  if (!file) return false;
+  unsigned short width = width_Emulator * scale;
+  fprintf(file, "P4\n%u %u\n", width, 64 * scale);
+  for (unsigned short y = 0; y < 64 * scale; y++) {
+    uint8_t packed = 0;
+    for (unsigned short x = 0; x < width; x++) {
+      packed = packed << 1 | pixels[y / scale * width_Emulator + x / scale];
+      if (x % 8 == 7) {
+        fputc(packed, file);
+        packed = 0;
+      }
+    }
+    if (width % 8) fputc(packed << (8 - width % 8), file);
+  }
+  return fclose(file) == 0;
+}
+
+
+void writeText_Emulator(FILE *file) {
+  for (uint8_t line = 0; line < 4; line++) {
+    uint8_t row, column;
+    locate_Emulator(0, line * 16, &row, &column);
+    for (unsigned short cell = column / 16; cell < (column + width_Emulator) / 16; cell++) {
+      uint16_t word = ddram_Emulator[row / 16 * 16 + cell];
+      uint8_t high = word >> 8, low = word;
+      if (high == 0x00 && low % 2 == 0 && low <= 6) fprintf(file, "{%u}", low / 2);
+      else if (high >= 0xA1) fprintf(file, "<%04X>", word);
+      else fprintf(file, "%c%c", high >= ' ' && high < 0x7F ? high : '.', low >= ' ' && low < 0x7F ? low : '.');
+    }
+    fputc('\n', file);
+  }
+}
+
+
+void startRecording_Emulator(FILE *file) {
+  recording_Emulator = file;
+}
+
+
+bool replay_Emulator(FILE *file) {
+  unsigned long long time;
+  unsigned int data;
+  int matched;
+  while ((matched = fscanf(file, "%llu %x", &time, &data)) == 2) {
+    if (time > now_Emulator) now_Emulator = time;
+    receiveByte_Emulator(data);
+  }
+  return matched == EOF;
+}
@@ -0,0 +1,65 @@
+#ifndef EMULATOR_ST7920_H
+#define EMULATOR_ST7920_H
+
+
+/* ST7920 model fed with the bytes of the serial protocol.
+   It keeps DDRAM, CGRAM and GDRAM in the controller layout (64 rows of 256 pixels),
+   folds them onto the panel the same way as the 128*64 module does, and times every
+   instruction with the execution times of the datasheet.
+   An instruction that arrives while the previous one is still executing is counted
+   as a timing violation, the real chip would lose or garble it.
+   Characters of the ROM fonts (HCGROM, CGROM) are not modelled, they are drawn as
+   outlined boxes in images and by their codes in text dumps. */
+
+
+#include <stdint.h>
+#include <stdio.h>
+
+
+struct Counters_Emulator {
+  unsigned long bytes; // bytes received
+  unsigned long instructions; // instructions executed, RS = 0
+  unsigned long dataWrites; // bytes written into DDRAM/CGRAM/GDRAM, RS = 1
+  unsigned long violations; // instructions or data received while busy
+  unsigned long protocolErrors; // nibble without sync, malformed sync, read requests
+};
+
+
+/* Power on state of a panel of width 128 or 256 pixels (height is 64)
+   driven at clock Hz, which sets the time taken by each byte. */
+void initialize_Emulator(unsigned short width, unsigned long clock);
+
+// Clock in one byte, advances time by 8 bits.
+void receiveByte_Emulator(uint8_t data);
+
+// Let time pass (e.g. delayMicroseconds of the driver).
+void delay_Emulator(unsigned long us);
+
+// Simulated time since initialization.
+uint64_t nanoseconds_Emulator();
+
+// Simulated time when the instruction being executed finishes, at least the current time.
+uint64_t idleNanoseconds_Emulator();
+
+const Counters_Emulator *getCounters_Emulator();
+
+/* Panel pixels as seen by eye: text and graphics combined, reversed lines,
+   vertical scroll and display on/off applied. pixels[y * width + x] is 0 or 1. */
+void render_Emulator(uint8_t pixels[]);
+
+// Write rendered panel as binary PBM, each pixel enlarged to scale*scale.
+bool writeImage_Emulator(const char *path, uint8_t scale);
+
+/* Write the 4 visible text lines, half characters as ASCII (other codes as '.'),
+   full characters as <XXXX> and CGRAM glyphs as {n}. */
+void writeText_Emulator(FILE *file);
+
+/* Write every received byte as "nanoseconds hex" line into file, NULL stops recording.
+   The time is when the first bit of the byte is clocked. */
+void startRecording_Emulator(FILE *file);
+
+/* Feed a recorded stream into the emulator, keeping the recorded gaps between bytes.
+   Return false when the file is malformed. */
+bool replay_Emulator(FILE *file);
+
+#endif
@@ -0,0 +1,206 @@
+/* Desktop harness for driver_st7920 running against the emulator.
+
+   st7920_host run [directory]
+     Run every drawing path once as a frame, print bytes, instructions and simulated time
+     of each frame, write the panel image of each frame (NN_name.pbm) and the whole byte
+     stream (session.stream) into directory. Exit status is 1 when the emulator saw
+     a timing violation or protocol error, so it can be used as a regression check.
+
+   st7920_host replay <stream> <image.pbm>
+     Feed a recorded stream into a fresh emulator, print its counters and write the image.
+
+   st7920_host benchmark
+     Run benchmark_ST7920() of main/ in simulated time, output is the same as over Serial. */
+
+
+#include <Arduino.h>
+#include <stdlib.h>
+#include "driver_st7920.h"
+#include "clock_face.h"
+#include "gb2312.h"
+#include "benchmark_st7920.h"
+#include "emulator_st7920.h"
+
+
+#define SCALE_HOST 4 // image pixels per panel pixel
+
+
+static Counters_Emulator start_Host;
+static uint64_t startTime_Host;
+static byte frames_Host = 0;
+static const char *directory_Host = ".";
+static bool failed_Host = false;
+
+
+// Let the previous frame finish on the panel, then take the counters.
+static void beginFrame_Host() {
+  delay_Emulator((idleNanoseconds_Emulator() - nanoseconds_Emulator() + 999) / 1000);
+  start_Host = *getCounters_Emulator();
+  startTime_Host = nanoseconds_Emulator();
+}
+
+
+static void endFrame_Host(const char *name) {
+  const Counters_Emulator *counters = getCounters_Emulator();
+  unsigned long bytes = counters->bytes - start_Host.bytes;
+  unsigned long instructions = counters->instructions - start_Host.instructions;
+  unsigned long dataWrites = counters->dataWrites - start_Host.dataWrites;
+  unsigned long violations = counters->violations - start_Host.violations;
+  unsigned long errors = counters->protocolErrors - start_Host.protocolErrors;
+  double call = (nanoseconds_Emulator() - startTime_Host) / 1000.0;
+  double done = (idleNanoseconds_Emulator() - startTime_Host) / 1000.0;
+
+  printf("%-32s %6lu %6lu %6lu %10.1f %10.1f %4lu %4lu\n",
+         name, bytes, instructions, dataWrites, call, done, violations, errors);
+  if (violations || errors) failed_Host = true;
+
+  char path[512];
+  snprintf(path, sizeof(path), "%s/%02u_%s.pbm", directory_Host, frames_Host++, name);
+  for (char *c = strrchr(path, '/') + 1; *c; c++) if (*c == ' ' || *c == ',') *c = '_';
+  if (!writeImage_Emulator(path, SCALE_HOST)) fprintf(stderr, "can't write %s\n", path);
+}
+
+
+static void run_Host() {
+  char path[512];
+  snprintf(path, sizeof(path), "%s/session.stream", directory_Host);
+  FILE *stream = fopen(path, "w");
+  if (!stream) fprintf(stderr, "can't write %s\n", path);
+  startRecording_Emulator(stream);
+
+  printf("%-32s %6s %6s %6s %10s %10s %4s %4s\n",
+         "frame", "bytes", "instr", "data", "call us", "done us", "viol", "err");
+
+  beginFrame_Host();
+  initialize_ST7920();
+  endFrame_Host("initialize");
+
+  char halfChars[POSITIONS_ST7920 * 2];
+  for (byte i = 0; i < sizeof(halfChars); i++) halfChars[i] = 'A' + i % 26;
+  beginFrame_Host();
+  printHalfCharacters_ST7920(halfChars, sizeof(halfChars), 0, 0);
+  endFrame_Host("half characters, full screen");
+
+  halfChars[7] = '0';
+  beginFrame_Host();
+  printHalfCharacters_ST7920(halfChars, sizeof(halfChars), 0, 0);
+  endFrame_Host("half characters, one digit");
+
+  short fullChars[POSITIONS_ST7920];
+  for (byte i = 0; i < POSITIONS_ST7920; i++) fullChars[i] = 0xB0A1 + i;
+  beginFrame_Host();
+  printFullCharacters_ST7920(fullChars, POSITIONS_ST7920, 0, 0);
+  endFrame_Host("full characters, full screen");
+
+  beginFrame_Host();
+  printText_ST7920("\xCE\xC2\xB6\xC8 23.5C", 1, 1);
+  endFrame_Host("mixed text, odd column");
+
+  beginFrame_Host();
+  print_GB2312(F("温度 23.5℃ ✓"), 2, 0); // the check mark isn't in the table
+  endFrame_Host("UTF-8 text");
+
+  byte glyph[32];
+  for (byte i = 0; i < 32; i++) glyph[i] = i % 2 ? 0b00001111 : 0b11110000;
+  short glyphCode = GLYPH_ST7920(1);
+  beginFrame_Host();
+  setGlyph_ST7920(1, glyph);
+  printFullCharacters_ST7920(&glyphCode, 1, 1, 3);
+  endFrame_Host("glyph");
+
+  beginFrame_Host();
+  setLineReverse_ST7920(0, true);
+  endFrame_Host("line reverse");
+
+  beginFrame_Host();
+  setLineReverse_ST7920(0, false);
+  clearCharacterDisplay_ST7920();
+  endFrame_Host("clear");
+
+  setGraphicDisplay_ST7920(true);
+  clearFramebuffer_ST7920();
+  fillRectangle_ST7920(0, 0, WIDTH_ST7920, 64, true);
+  beginFrame_Host();
+  flushFramebuffer_ST7920();
+  endFrame_Host("GDRAM flush, full screen");
+
+  fillRectangle_ST7920(16, 16, 16, 32, false);
+  beginFrame_Host();
+  flushFramebuffer_ST7920();
+  endFrame_Host("GDRAM flush, one digit");
+
+  clearFramebuffer_ST7920();
+  flushFramebuffer_ST7920();
+  Time_DS3231 time = {0x59, 0x34, 0x12, 1, 0x01, 0x01, 0x26};
+  beginFrame_Host();
+  initialize_ClockFace();
+  render_ClockFace(&time);
+  flushFramebuffer_ST7920();
+  endFrame_Host("clock face, first frame");
+
+  time.seconds = 0x00;
+  time.minutes = 0x35;
+  beginFrame_Host();
+  render_ClockFace(&time);
+  flushFramebuffer_ST7920();
+  endFrame_Host("clock face, minute carry");
+
+  beginFrame_Host();
+  invertRectangle_ST7920(16, 16, 16, 32);
+  flushFramebuffer_ST7920();
+  endFrame_Host("highlight toggle, one digit");
+
+  invertRectangle_ST7920(16, 16, 16, 32);
+  flushFramebuffer_ST7920();
+
+#if PAGES_ST7920 > 1
+  beginFrame_Host();
+  setDrawPage_ST7920(1);
+  printHalfCharacters_ST7920(F("page 1"), 0, 0);
+  flipPages_ST7920();
+  endFrame_Host("page flip");
+#endif
+
+  startRecording_Emulator(NULL);
+  if (stream) fclose(stream);
+}
+
+
+static bool replay_Host(const char *streamPath, const char *imagePath) {
+  FILE *stream = fopen(streamPath, "r");
+  if (!stream) {
+    fprintf(stderr, "can't read %s\n", streamPath);
+    return false;
+  }
+  bool valid = replay_Emulator(stream);
+  fclose(stream);
+  if (!valid) fprintf(stderr, "malformed stream %s\n", streamPath);
+
+  const Counters_Emulator *counters = getCounters_Emulator();
+  printf("bytes %lu, instructions %lu, data %lu, done %.1f us, violations %lu, errors %lu\n",
+         counters->bytes, counters->instructions, counters->dataWrites,
+         idleNanoseconds_Emulator() / 1000.0, counters->violations, counters->protocolErrors);
+  writeText_Emulator(stdout);
+  return valid && writeImage_Emulator(imagePath, SCALE_HOST) &&
+         counters->violations == 0 && counters->protocolErrors == 0;
+}
+
+
+int main(int argc, char *argv[]) {
+  initialize_Emulator(WIDTH_ST7920, SPI_CLOCK_ST7920);
+
+  if (argc >= 2 && strcmp(argv[1], "run") == 0) {
+    if (argc >= 3) directory_Host = argv[2];
+    run_Host();
+    writeText_Emulator(stdout);
+    return failed_Host ? 1 : 0;
+  }
+  if (argc == 4 && strcmp(argv[1], "replay") == 0) return replay_Host(argv[2], argv[3]) ? 0 : 1;
+  if (argc == 2 && strcmp(argv[1], "benchmark") == 0) {
+    benchmark_ST7920();
+    return getCounters_Emulator()->violations ? 1 : 0;
+  }
+
+  fprintf(stderr, "usage: %s run [directory] | replay <stream> <image.pbm> | benchmark\n", argv[0]);
+  return 2;
+}
@@ -0,0 +1,133 @@
+#include <Arduino.h>
+#include "driver_st7920.h"
+#include "benchmark_st7920.h"
+
+
+#define REPEATS_BENCHMARK 20 // times each case runs, results are averaged
+
+static unsigned long callTime_Benchmark; // us spent inside the driver functions
+static unsigned long doneTime_Benchmark; // us until the display finished the instructions
+static unsigned long startTime_Benchmark;
+
+
+static void start_Benchmark() {
+  waitUntilIdle_ST7920(); // nothing from the previous case is counted
+  startTime_Benchmark = micros();
+}
+
+
+static void stop_Benchmark() {
+  unsigned long returned = micros();
+  waitUntilIdle_ST7920();
+  unsigned long done = micros();
+  callTime_Benchmark += returned - startTime_Benchmark;
+  doneTime_Benchmark += done - startTime_Benchmark;
+}
+
+
+/* repeats: number of runs measured since the last report.
+   bytes: payload bytes of one run. */
+static void report_Benchmark(const __FlashStringHelper *name, byte repeats, unsigned short bytes) {
+  unsigned long call = callTime_Benchmark / repeats;
+  unsigned long done = doneTime_Benchmark / repeats;
+  if (done == 0) done = 1; // micros() resolution is 4 us
+
+  Serial.print(name);
+  Serial.print(F(": call "));
+  Serial.print(call);
+  Serial.print(F(" us, done "));
+  Serial.print(done);
+  Serial.print(F(" us, cycles "));
+  Serial.print(done * clockCyclesPerMicrosecond());
+  Serial.print(F(", bytes/s "));
+  Serial.print(bytes * 1000000UL / done);
+  Serial.print(F(", frames/s "));
+  Serial.println(1000000UL / done);
+
+  callTime_Benchmark = 0;
+  doneTime_Benchmark = 0;
+}
+
+
+void benchmark_ST7920() {
+  Serial.println(F("ST7920 benchmark"));
+  Serial.print(F("async "));
+  Serial.print(ASYNC_ST7920);
+  Serial.print(F(", software SPI "));
+  Serial.print(SOFTWARE_SPI_ST7920);
+  initialize_ST7920();
+  Serial.print(F(", SPI clock "));
+  Serial.print(getClock_ST7920());
+  Serial.print(F(", slack "));
+  Serial.println(getSlack_ST7920());
+
+  for (byte i = 0; i < 5; i++) {
+    start_Benchmark();
+    initialize_ST7920();
+    stop_Benchmark();
+  }
+  report_Benchmark(F("initialize"), 5, 0);
+
+  for (byte i = 0; i < REPEATS_BENCHMARK; i++) {
+    start_Benchmark();
+    clearCharacterDisplay_ST7920();
+    stop_Benchmark();
+  }
+  report_Benchmark(F("clear"), REPEATS_BENCHMARK, 0);
+
+  // Every cell changes between two runs, so the DDRAM shadow can't skip anything.
+  short fullChars[POSITIONS_ST7920];
+  for (byte i = 0; i < REPEATS_BENCHMARK; i++) {
+    for (byte j = 0; j < POSITIONS_ST7920; j++) fullChars[j] = 0xB0A1 + j + i % 2 * POSITIONS_ST7920;
+    start_Benchmark();
+    printFullCharacters_ST7920(fullChars, POSITIONS_ST7920, 0, 0);
+    stop_Benchmark();
+  }
+  report_Benchmark(F("full characters, full screen"), REPEATS_BENCHMARK, POSITIONS_ST7920 * 2);
+
+  char halfChars[POSITIONS_ST7920 * 2];
+  for (byte i = 0; i < REPEATS_BENCHMARK; i++) {
+    for (byte j = 0; j < POSITIONS_ST7920 * 2; j++) halfChars[j] = (i % 2 ? 'a' : 'A') + j % 26;
+    start_Benchmark();
+    printHalfCharacters_ST7920(halfChars, POSITIONS_ST7920 * 2, 0, 0);
+    stop_Benchmark();
+  }
+  report_Benchmark(F("half characters, full screen"), REPEATS_BENCHMARK, POSITIONS_ST7920 * 2);
+
+  // Typical clock tick: only the last digit of the seconds changes.
+  char time[] = "12:34:50";
+  for (byte i = 0; i < REPEATS_BENCHMARK; i++) {
+    time[7] = '0' + i % 10;
+    start_Benchmark();
+    printHalfCharacters_ST7920(time, 8, 0, 0);
+    stop_Benchmark();
+  }
+  report_Benchmark(F("half characters, one digit"), REPEATS_BENCHMARK, 2);
+
+  clearCharacterDisplay_ST7920();
+  setGraphicDisplay_ST7920(true);
+  clearFramebuffer_ST7920();
+  flushFramebuffer_ST7920();
+
+  for (byte i = 0; i < REPEATS_BENCHMARK; i++) {
+    fillRectangle_ST7920(0, 0, WIDTH_ST7920, 64, i % 2 == 0);
+    start_Benchmark();
+    flushFramebuffer_ST7920();
+    stop_Benchmark();
+  }
+  report_Benchmark(F("GDRAM flush, full screen"), REPEATS_BENCHMARK, WIDTH_ST7920 * 64 / 8);
+
+  // A 16*32 big digit aligned to one GDRAM word.
+  for (byte i = 0; i < REPEATS_BENCHMARK; i++) {
+    fillRectangle_ST7920(16, 16, 16, 32, i % 2 == 1);
+    start_Benchmark();
+    flushFramebuffer_ST7920();
+    stop_Benchmark();
+  }
+  report_Benchmark(F("GDRAM flush, one digit"), REPEATS_BENCHMARK, 32 * 2);
+
+  clearFramebuffer_ST7920();
+  flushFramebuffer_ST7920();
+  setGraphicDisplay_ST7920(false);
+  waitUntilIdle_ST7920();
+}
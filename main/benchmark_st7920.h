@@ -0,0 +1,19 @@
+#ifndef BENCHMARK_ST7920_H
+#define BENCHMARK_ST7920_H
+
+
+#include <Arduino.h>
+
+
+/* Time the drawing paths of the display driver and print a report over Serial.
+   Serial must be started before calling it.
+   For each case the report shows:
+   call - average time until the function returns (CPU cost),
+   done - average time until the display finished all instructions,
+   cycles - done time in CPU cycles,
+   bytes/s - payload bytes (DDRAM/GDRAM data) written per second,
+   frames/s - how many times the case can be repeated per second.
+   Results are comparable between builds with different driver options. */
+void benchmark_ST7920();
+
+#endif
@@ -0,0 +1,132 @@
+#include <Arduino.h>
+#include "driver_st7920.h"
+#include "driver_at24c32.h"
+#include "calibration.h"
+
+
+// Hardware SPI clocks of a 16 MHz Nano, slowest first.
+static const unsigned long clocks_Calibration[] PROGMEM = {250000, 500000, 1000000, 2000000, 4000000};
+// us added to execution times, smallest first.
+static const byte slacks_Calibration[] PROGMEM = {0, 16, 48};
+
+#define CLOCKS_CALIBRATION (sizeof(clocks_Calibration) / sizeof(clocks_Calibration[0]))
+#define SLACKS_CALIBRATION (sizeof(slacks_Calibration) / sizeof(slacks_Calibration[0]))
+
+
+static byte checksum_Calibration(const Record_Calibration *record) {
+  const byte *bytes = (const byte *)record;
+  byte sum = 0;
+  for (byte i = 0; i < sizeof(Record_Calibration) - 1; i++) sum += bytes[i];
+  return ~sum;
+}
+
+
+bool load_Calibration() {
+  Record_Calibration record;
+  if (!readBytes_AT24C32(START_CALIBRATION, (byte *)&record, sizeof(Record_Calibration))) return false;
+  if (record.magic != MAGIC_CALIBRATION || record.checksum != checksum_Calibration(&record)) return false;
+  setTiming_ST7920(record.clock, record.slack);
+  return true;
+}
+
+
+static bool save_Calibration(unsigned long clock, byte slack) {
+  Record_Calibration record;
+  record.magic = MAGIC_CALIBRATION;
+  record.clock = clock;
+  record.slack = slack;
+  record.checksum = checksum_Calibration(&record);
+  if (!writeBytes_AT24C32(START_CALIBRATION, (const byte *)&record, sizeof(Record_Calibration))) return false;
+  if (!flush_AT24C32() || !waitForWrites_AT24C32()) return false;
+
+  // Read back what the chip holds now, the buffer is empty after the writes finished.
+  Record_Calibration stored;
+  if (!readBytes_AT24C32(START_CALIBRATION, (byte *)&stored, sizeof(Record_Calibration))) return false;
+  return memcmp(&stored, &record, sizeof(Record_Calibration)) == 0;
+}
+
+
+/* Text on all 4 lines and a frame around the screen, so that instructions, DDRAM data
+   and GDRAM data are all sent at the candidate timing. */
+static void drawPattern_Calibration(unsigned long clock, byte slack) {
+  char number[11];
+
+  setTiming_ST7920(clock, slack);
+  initialize_ST7920();
+  printHalfCharacters_ST7920(F("SPI"), 0, 1);
+  ultoa(clock, number, 10);
+  printHalfCharacters_ST7920(number, strlen(number), 0, 5);
+  printHalfCharacters_ST7920(F("slack"), 1, 1);
+  ultoa(slack, number, 10);
+  printHalfCharacters_ST7920(number, strlen(number), 1, 7);
+  printHalfCharacters_ST7920(F("ABCDEFGHIJKLMN"), 2, 1);
+  printHalfCharacters_ST7920(F("0123456789+-*/"), 3, 1);
+
+  setGraphicDisplay_ST7920(true);
+  clearFramebuffer_ST7920();
+  fillRectangle_ST7920(0, 0, WIDTH_ST7920, 1, true);
+  fillRectangle_ST7920(0, 63, WIDTH_ST7920, 1, true);
+  fillRectangle_ST7920(0, 0, 1, 64, true);
+  fillRectangle_ST7920(WIDTH_ST7920 - 1, 0, 1, 64, true);
+  flushFramebuffer_ST7920();
+  waitUntilIdle_ST7920();
+}
+
+
+static bool confirm_Calibration() {
+  while (Serial.available()) Serial.read(); // drop earlier input
+  unsigned long start = millis();
+  while (millis() - start < ANSWER_TIMEOUT_CALIBRATION) {
+    int answer = Serial.read();
+    if (answer == 'y') return true;
+    if (answer == 'n') return false;
+  }
+  return false;
+}
+
+
+bool run_Calibration() {
+  unsigned long oldClock = getClock_ST7920();
+  byte oldSlack = getSlack_ST7920();
+  unsigned long bestClock = 0;
+  byte bestSlack = 0;
+
+  Serial.println(F("ST7920 calibration: answer y if the 4 lines and the frame look right, n otherwise"));
+  for (byte i = 0; i < CLOCKS_CALIBRATION; i++) {
+    unsigned long clock = pgm_read_dword(&clocks_Calibration[i]);
+    bool passed = false;
+    for (byte j = 0; j < SLACKS_CALIBRATION && !passed; j++) {
+      byte slack = pgm_read_byte(&slacks_Calibration[j]);
+      drawPattern_Calibration(clock, slack);
+      Serial.print(F("clock "));
+      Serial.print(clock);
+      Serial.print(F(" Hz, slack "));
+      Serial.print(slack);
+      Serial.print(F(" us? "));
+      passed = confirm_Calibration();
+      Serial.println(passed ? 'y' : 'n');
+      if (passed) {
+        bestClock = clock;
+        bestSlack = slack;
+      }
+    }
+    if (!passed) break; // faster clocks won't do better
+  }
+
+  bool found = bestClock != 0;
+  if (found) {
+    setTiming_ST7920(bestClock, bestSlack);
+    if (!save_Calibration(bestClock, bestSlack)) Serial.println(F("can't save calibration"));
+  } else {
+    setTiming_ST7920(oldClock, oldSlack);
+  }
+  initialize_ST7920();
+  setGraphicDisplay_ST7920(false);
+
+  Serial.print(F("using clock "));
+  Serial.print(getClock_ST7920());
+  Serial.print(F(" Hz, slack "));
+  Serial.print(getSlack_ST7920());
+  Serial.println(F(" us"));
+  return found;
+}
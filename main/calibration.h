@@ -0,0 +1,37 @@
+#ifndef CALIBRATION_H
+#define CALIBRATION_H
+
+
+/* Per-module SPI clock and delay slack of the ST7920, found by calibration and kept in the AT24C32.
+   ST7920 can't be read in serial mode, so every candidate setting is verified by eye:
+   a test pattern is drawn and the user answers 'y' or 'n' over Serial.
+   Settings area of AT24C32 is 0x0F80-0x0FFF, after the glyph cache (see glyph_cache.h). */
+
+
+#include <Arduino.h>
+
+
+#define START_CALIBRATION 0x0F80 // address of the record in AT24C32
+#define MAGIC_CALIBRATION 0xC5 // first byte of a written record
+#define ANSWER_TIMEOUT_CALIBRATION 30000 // ms to wait for an answer, no answer counts as 'n'
+
+struct __attribute__((packed)) Record_Calibration {
+  byte magic; // MAGIC_CALIBRATION
+  uint32_t clock; // Hz for setTiming_ST7920()
+  byte slack; // us for setTiming_ST7920()
+  byte checksum; // ~sum of the bytes above
+};
+
+
+/* Read the record and pass it to setTiming_ST7920(), call it before initialize_ST7920().
+   Return false when there is no valid record, the defaults of the driver are kept then. */
+bool load_Calibration();
+
+/* Step the clock up from the slowest candidate, trying each slack from small to large,
+   until no slack works for a clock. The fastest setting confirmed is saved and applied.
+   It blocks until finished (minutes), so call it outside scheduler tasks.
+   The display is left initialized and empty.
+   Return false when nothing was confirmed, the previous setting is restored then. */
+bool run_Calibration();
+
+#endif
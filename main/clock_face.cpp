@@ -0,0 +1,49 @@
+#include <Arduino.h>
+#include "driver_st7920.h"
+#include "font.h"
+#include "font_clock_digits.h"
+#include "clock_face.h"
+
+
+#define TOP_CLOCK_FACE 16 // first pixel row of digits, centered vertically
+#define HEIGHT_CLOCK_FACE 32
+
+// Left pixel column of the digits H H M M S S.
+static const byte columns_ClockFace[6] = {0, 16, 48, 64, 96, 112};
+
+static byte digits_ClockFace[6]; // value drawn at each digit, 0xFF when unknown
+
+
+static void drawDigit_ClockFace(byte index, byte value) {
+  drawGlyph_Font(&clockDigits_Font, value, columns_ClockFace[index], TOP_CLOCK_FACE);
+  digits_ClockFace[index] = value;
+}
+
+
+void invalidate_ClockFace() {
+  memset(digits_ClockFace, 0xFF, sizeof(digits_ClockFace));
+}
+
+
+void initialize_ClockFace() {
+  setGraphicDisplay_ST7920(true);
+  clearFramebuffer_ST7920();
+  invalidate_ClockFace();
+
+  // Colons in the middle of columns 32 and 80.
+  for (byte x = 38; x <= 86; x += 48) {
+    fillRectangle_ST7920(x, TOP_CLOCK_FACE + 8, 4, 4, true);
+    fillRectangle_ST7920(x, TOP_CLOCK_FACE + 20, 4, 4, true);
+  }
+}
+
+
+void render_ClockFace(const Time_DS3231 *time) {
+  byte values[6] = {
+    (byte)(time->hours >> 4), (byte)(time->hours & 0b00001111),
+    (byte)(time->minutes >> 4), (byte)(time->minutes & 0b00001111),
+    (byte)(time->seconds >> 4), (byte)(time->seconds & 0b00001111)};
+
+  for (byte i = 0; i < 6; i++)
+    if (values[i] != digits_ClockFace[i] && values[i] < 10) drawDigit_ClockFace(i, values[i]);
+}
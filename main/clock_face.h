@@ -0,0 +1,26 @@
+#ifndef CLOCK_FACE_H
+#define CLOCK_FACE_H
+
+
+/* HH:MM:SS in large 7-segment digits (font_clock_digits.h) on the GDRAM framebuffer.
+   Each digit fills one 16 pixels wide GDRAM word column and is 32 pixels high,
+   the colons take the two columns left, so 8 columns fill the 128 pixels wide display.
+   Only digits whose value changed are drawn again, and only the rows that
+   differ end up in dirty words, so most ticks touch part of one word column. */
+
+
+#include <Arduino.h>
+#include "driver_ds3231.h"
+
+
+// Turn on graphic display, clear it and draw the colons.
+void initialize_ClockFace();
+
+/* Draw changed digits of time into the framebuffer.
+   Nothing is sent, call flushFramebuffer_ST7920() or endFrame_ST7920() afterwards. */
+void render_ClockFace(const Time_DS3231 *time);
+
+// Forget the digits drawn, so that the next render draws all of them.
+void invalidate_ClockFace();
+
+#endif
@@ -0,0 +1,45 @@
+#include <Arduino.h>
+#include "scheduler.h"
+#include "profiler.h"
+#include "pacing.h"
+#include "esp_link.h"
+#include "console.h"
+
+
+static bool calibration_Console = false; // true - 'k' was received and calibration hasn't started
+
+
+bool takeCalibration_Console() {
+  if (!calibration_Console) return false;
+  calibration_Console = false;
+  return true;
+}
+
+
+void poll_Console() {
+  if (Serial.available() == 0) return;
+
+  switch (Serial.read()) {
+    case 't':
+      report_Scheduler(Serial);
+      break;
+    case 'p':
+      report_Profiler(Serial);
+      break;
+    case 'f':
+      report_Pacing(Serial);
+      break;
+    case 'n':
+      report_EspLink(Serial);
+      break;
+    case 'c':
+      resetCounters_Scheduler();
+      reset_Profiler();
+      reset_Pacing();
+      Serial.println(F("counters cleared"));
+      break;
+    case 'k':
+      calibration_Console = true;
+      break;
+  }
+}
@@ -0,0 +1,24 @@
+#ifndef CONSOLE_H
+#define CONSOLE_H
+
+
+/* Single character commands over Serial:
+   't' - print task counters of the scheduler.
+   'p' - print cycle counters of the profiler (see PROFILER_ENABLED).
+   'f' - print frame pacing, latency from the RTC tick to the panel (see pacing.h).
+   'n' - print the ESP-12F link and network time sync (see esp_link.h, time_sync.h).
+   'c' - clear the counters.
+   'k' - calibrate SPI timing of the display (see calibration.h), then redraw the clock face.
+         It's only requested here, calibration blocks for minutes and runs outside the scheduler. */
+
+
+#include <Arduino.h>
+
+
+// Handle at most one received command, return immediately if nothing was received.
+void poll_Console();
+
+// Return true once after 'k' was received.
+bool takeCalibration_Console();
+
+#endif
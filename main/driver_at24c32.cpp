@@ -0,0 +1,157 @@
+#include <Arduino.h>
+#include "driver_twi.h"
+#include "driver_at24c32.h"
+#include "profiler.h"
+
+
+/* The chip doesn't acknowledge its address during a write cycle (10 ms at most),
+   every transaction repeats START until it does. One attempt takes about 30 us at 400 kHz. */
+#define POLL_RETRIES_AT24C32 1000
+
+/* Write-combining buffer for one page.
+   bufferMask_AT24C32 bit n set - buffer_AT24C32[n] holds data not written to the chip yet. */
+static byte buffer_AT24C32[PAGE_SIZE_AT24C32];
+static unsigned short bufferPage_AT24C32 = 0; // first address of the buffered page
+static unsigned long bufferMask_AT24C32 = 0;
+volatile static byte queuedWrites_AT24C32 = 0; // page writes from the buffer still in TWI queue
+volatile static bool failed_AT24C32 = false; // a queued write of the buffered page wasn't acknowledged
+
+
+void initialize_AT24C32() {
+  initialize_TWI();
+}
+
+
+static void transaction_AT24C32(Transaction_TWI *transaction, unsigned short address) {
+  memset(transaction, 0, sizeof(Transaction_TWI));
+  transaction->address = ADDRESS_AT24C32;
+  transaction->header[0] = address >> 8 & 0b00001111; // first word address
+  transaction->header[1] = address; // second word address
+  transaction->headerLength = 2;
+  transaction->retries = POLL_RETRIES_AT24C32;
+}
+
+
+static void finishQueuedWrite_AT24C32(byte result) {
+  queuedWrites_AT24C32 -= 1;
+  if (result != DONE_TWI) failed_AT24C32 = true;
+}
+
+
+// The buffer is read by interrupt until its queued writes finish.
+static void waitForBuffer_AT24C32() {
+  while (queuedWrites_AT24C32 > 0);
+}
+
+
+/* Write bytes within one page (no wrap) in one write cycle.
+   queued: true - data is the buffer, queue the write and return, false - wait for it. */
+static bool writePage_AT24C32(unsigned short address, const byte data[], byte length, bool queued) {
+  PROBE_PROFILER(I2C_WRITE_PROFILER);
+  Transaction_TWI transaction;
+  transaction_AT24C32(&transaction, address);
+  transaction.writeData = data;
+  transaction.writeLength = length;
+  if (!queued) return run_TWI(&transaction) == DONE_TWI;
+
+  transaction.callback = finishQueuedWrite_AT24C32;
+  byte oldSREG = SREG;
+  cli();
+  queuedWrites_AT24C32 += 1;
+  SREG = oldSREG;
+  queue_TWI(&transaction);
+  return true;
+}
+
+
+// Queue the buffered bytes as page writes.
+static void commitBuffer_AT24C32() {
+  byte start = 0;
+  while (bufferMask_AT24C32) {
+    // Skip to the next run of buffered bytes and queue it as one page write.
+    while (!(bufferMask_AT24C32 & 1UL << start)) start++;
+    byte end = start;
+    while (end < PAGE_SIZE_AT24C32 && bufferMask_AT24C32 & 1UL << end) end++;
+    writePage_AT24C32(bufferPage_AT24C32 + start, &buffer_AT24C32[start], end - start, true);
+    for (byte i = start; i < end; i++) bufferMask_AT24C32 &= ~(1UL << i);
+    start = end;
+  }
+}
+
+
+bool flush_AT24C32() {
+  commitBuffer_AT24C32();
+  byte oldSREG = SREG;
+  cli();
+  bool failed = failed_AT24C32;
+  failed_AT24C32 = false;
+  SREG = oldSREG;
+  return !failed;
+}
+
+
+bool waitForWrites_AT24C32() {
+  waitForBuffer_AT24C32();
+  byte oldSREG = SREG;
+  cli();
+  bool failed = failed_AT24C32;
+  failed_AT24C32 = false;
+  SREG = oldSREG;
+  return !failed;
+}
+
+
+bool readBytes_AT24C32(unsigned short address, byte data[], unsigned short length) {
+  PROBE_PROFILER(I2C_READ_PROFILER);
+  for (unsigned short done = 0; done < length;) {
+    byte count = min(length - done, 255);
+    // dummy write sets address, then repeated start
+    Transaction_TWI transaction;
+    transaction_AT24C32(&transaction, address + done);
+    transaction.readData = &data[done];
+    transaction.readLength = count;
+    if (run_TWI(&transaction) != DONE_TWI) return false;
+    done += count;
+  }
+
+  // Bytes waiting in the buffer are newer than those in the chip.
+  for (unsigned short i = 0; i < length; i++) {
+    unsigned short offset = address + i - bufferPage_AT24C32;
+    if (offset < PAGE_SIZE_AT24C32 && bufferMask_AT24C32 & 1UL << offset) data[i] = buffer_AT24C32[offset];
+  }
+  return true;
+}
+
+
+bool writeBytes_AT24C32(unsigned short address, const byte data[], unsigned short length) {
+  while (length > 0) {
+    unsigned short page = address & ~(PAGE_SIZE_AT24C32 - 1);
+    byte offset = address - page;
+    byte count = min(length, PAGE_SIZE_AT24C32 - offset);
+
+    if (count == PAGE_SIZE_AT24C32) {
+      // Whole page: drop its buffered bytes, they're overwritten anyway.
+      if (page == bufferPage_AT24C32) bufferMask_AT24C32 = 0;
+      if (!writePage_AT24C32(address, data, count, false)) return false;
+    } else {
+      if (page != bufferPage_AT24C32) {
+        /* The failure of a write of the old page belongs to it, not to this one.
+           It was already reported if its flush or wait was called, and it's dropped otherwise. */
+        commitBuffer_AT24C32();
+        waitForBuffer_AT24C32();
+        failed_AT24C32 = false;
+        bufferPage_AT24C32 = page;
+      }
+      waitForBuffer_AT24C32();
+      for (byte i = 0; i < count; i++) {
+        buffer_AT24C32[offset + i] = data[i];
+        bufferMask_AT24C32 |= 1UL << (offset + i);
+      }
+    }
+
+    address += count;
+    data += count;
+    length -= count;
+  }
+  return true;
+}
@@ -0,0 +1,43 @@
+#ifndef DRIVER_AT24C32_H
+#define DRIVER_AT24C32_H
+
+
+/* The AT24C32 is on the DS3231 module and shares its I2C bus (SDA - A4, SCL - A5).
+   A0-A2 are not connected and so stand for 1. */
+
+
+#include <Arduino.h>
+
+
+#define ADDRESS_AT24C32 0b1010111
+#define SIZE_AT24C32 4096 // bytes
+#define PAGE_SIZE_AT24C32 32 // bytes written in one write cycle at most
+
+
+// Start I2C (driver_twi), nothing is read or written.
+void initialize_AT24C32();
+
+/* Sequential read of length bytes starting from address into data, waits for it.
+   Bytes still held in the write-combining buffer are returned as well.
+   Return false when the chip didn't answer. */
+bool readBytes_AT24C32(unsigned short address, byte data[], unsigned short length);
+
+/* Write length bytes from data starting at address.
+   Small writes to the same page are collected in RAM and written in one write cycle,
+   the buffer is committed when a write goes to another page or flush_AT24C32() is called.
+   Whole pages are written directly with page writes, waiting for them.
+   Return false when the chip didn't answer a direct page write, buffered bytes can't fail here. */
+bool writeBytes_AT24C32(unsigned short address, const byte data[], unsigned short length);
+
+/* Queue the write-combining buffer to be written to the chip and return immediately.
+   Call it before power may be lost, e.g. after saving settings
+   (and waitUntilIdle_TWI() if power is about to go).
+   Return false when an earlier queued write of the buffered page failed. */
+bool flush_AT24C32();
+
+/* Wait until every write queued by flush_AT24C32() has been acknowledged by the chip.
+   Return false when one of them failed since the last flush or wait,
+   or since the buffer was loaded with its page. */
+bool waitForWrites_AT24C32();
+
+#endif
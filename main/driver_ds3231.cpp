@@ -0,0 +1,226 @@
+#include <Arduino.h>
+#include <avr/sleep.h>
+#include "driver_twi.h"
+#include "driver_ds3231.h"
+#include "profiler.h"
+
+
+static Time_DS3231 snapshot_DS3231; // time read from the RTC last time
+volatile static unsigned long snapshotMillis_DS3231 = 0; // millis() when the snapshot was read
+static Time_DS3231 incoming_DS3231; // filled by TWI interrupt, copied into snapshot when complete
+volatile static bool requesting_DS3231 = false; // true - a queued burst read hasn't finished
+volatile static bool fresh_DS3231 = false; // true - the snapshot was refreshed and not taken yet
+volatile static bool tick_DS3231 = false; // true - a falling edge of SQW happened and is not taken yet
+volatile static unsigned long snapshotMicros_DS3231 = 0; // micros() when the last read completed
+volatile static unsigned long tickMicros_DS3231 = 0; // micros() at the last falling edge of SQW
+
+
+byte bcdToDecimal_DS3231(byte bcd) {
+  return (bcd >> 4) * 10 + (bcd & 0b00001111);
+}
+
+
+byte decimalToBCD_DS3231(byte decimal) {
+  return (decimal / 10) << 4 | decimal % 10;
+}
+
+
+// Burst read of timekeeping registers: register pointer 0x00, repeated start, 7 bytes.
+static void timeTransaction_DS3231(Transaction_TWI *transaction) {
+  memset(transaction, 0, sizeof(Transaction_TWI));
+  transaction->address = ADDRESS_DS3231;
+  transaction->header[0] = 0x00;
+  transaction->headerLength = 1;
+  transaction->readData = (byte *)&incoming_DS3231;
+  transaction->readLength = sizeof(Time_DS3231);
+}
+
+
+// Take the incoming registers as the new snapshot, also called in interrupt.
+static void storeTime_DS3231(byte result) {
+  requesting_DS3231 = false;
+  if (result != DONE_TWI) return;
+  snapshot_DS3231 = incoming_DS3231;
+  snapshot_DS3231.hours &= 0b00111111; // clear 12/24 bit, the driver always sets 24-hour mode
+  snapshotMillis_DS3231 = millis();
+  snapshotMicros_DS3231 = micros();
+  fresh_DS3231 = true;
+}
+
+
+void initialize_DS3231() {
+  initialize_TWI();
+  readTime_DS3231();
+}
+
+
+bool readTime_DS3231() {
+  PROBE_PROFILER(I2C_READ_PROFILER);
+  Transaction_TWI transaction;
+  timeTransaction_DS3231(&transaction);
+  byte result = run_TWI(&transaction);
+  storeTime_DS3231(result);
+  return result == DONE_TWI;
+}
+
+
+bool requestTime_DS3231() {
+  if (requesting_DS3231) return false;
+  requesting_DS3231 = true;
+  Transaction_TWI transaction;
+  timeTransaction_DS3231(&transaction);
+  transaction.callback = storeTime_DS3231;
+  queue_TWI(&transaction);
+  return true;
+}
+
+
+bool takeTime_DS3231() {
+  if (!fresh_DS3231) return false;
+  fresh_DS3231 = false;
+  return true;
+}
+
+
+bool updateTime_DS3231() {
+  if (millis() - snapshotMillis_DS3231 < 1000) return false;
+  return readTime_DS3231();
+}
+
+
+void getTime_DS3231(Time_DS3231 *time) {
+  byte oldSREG = SREG;
+  cli(); // a queued read may replace the snapshot at any time
+  *time = snapshot_DS3231;
+  unsigned long snapshotMillis = snapshotMillis_DS3231;
+  SREG = oldSREG;
+  unsigned long elapsed = (millis() - snapshotMillis) / 1000;
+  if (elapsed == 0) return;
+
+  unsigned long seconds = bcdToDecimal_DS3231(time->seconds) + elapsed;
+  unsigned long minutes = bcdToDecimal_DS3231(time->minutes) + seconds / 60;
+  unsigned long hours = bcdToDecimal_DS3231(time->hours) + minutes / 60;
+  time->seconds = decimalToBCD_DS3231(seconds % 60);
+  time->minutes = decimalToBCD_DS3231(minutes % 60);
+  time->hours = decimalToBCD_DS3231(hours % 24);
+}
+
+
+void setTime_DS3231(const Time_DS3231 *time) {
+  Time_DS3231 registers = *time;
+  registers.hours &= 0b00111111; // bit 6 = 0 selects 24-hour mode
+
+  Transaction_TWI transaction;
+  memset(&transaction, 0, sizeof(Transaction_TWI));
+  transaction.address = ADDRESS_DS3231;
+  transaction.header[0] = 0x00;
+  transaction.headerLength = 1;
+  transaction.writeData = (const byte *)&registers;
+  transaction.writeLength = sizeof(Time_DS3231);
+  run_TWI(&transaction);
+  readTime_DS3231();
+}
+
+
+static void writeRegister_DS3231(byte address, byte value) {
+  PROBE_PROFILER(I2C_WRITE_PROFILER);
+  Transaction_TWI transaction;
+  memset(&transaction, 0, sizeof(Transaction_TWI));
+  transaction.address = ADDRESS_DS3231;
+  transaction.header[0] = address;
+  transaction.header[1] = value;
+  transaction.headerLength = 2;
+  run_TWI(&transaction);
+}
+
+
+static void countTick_DS3231() {
+  tickMicros_DS3231 = micros();
+  tick_DS3231 = true;
+}
+
+
+void startTick_DS3231() {
+  // Control register: oscillator on, INTCN = 0 (square wave), RS2 = RS1 = 0 (1 Hz), alarms off.
+  writeRegister_DS3231(0x0E, 0b00000000);
+  pinMode(SQW_PIN_DS3231, INPUT_PULLUP);
+  attachInterrupt(digitalPinToInterrupt(SQW_PIN_DS3231), countTick_DS3231, FALLING);
+}
+
+
+bool takeTick_DS3231() {
+  if (!tick_DS3231) return false;
+  tick_DS3231 = false;
+  return true;
+}
+
+
+// Interrupts write both while they're read.
+static unsigned long readMicros_DS3231(volatile unsigned long *micros) {
+  byte oldSREG = SREG;
+  cli();
+  unsigned long value = *micros;
+  SREG = oldSREG;
+  return value;
+}
+
+
+unsigned long getTickMicros_DS3231() {
+  return readMicros_DS3231(&tickMicros_DS3231);
+}
+
+
+unsigned long getSnapshotMicros_DS3231() {
+  return readMicros_DS3231(&snapshotMicros_DS3231);
+}
+
+
+void sleepUntilTick_DS3231() {
+  set_sleep_mode(SLEEP_MODE_IDLE);
+  cli();
+  if (!tick_DS3231) {
+    sleep_enable();
+    sei(); // the instruction after sei is always executed, so no interrupt is lost before sleeping
+    sleep_cpu();
+    sleep_disable();
+  }
+  sei();
+}
+
+
+short readTemperature_DS3231() {
+  byte registers[2]; // integer part in two's complement, fraction in bit 7 and 6
+
+  Transaction_TWI transaction;
+  memset(&transaction, 0, sizeof(Transaction_TWI));
+  transaction.address = ADDRESS_DS3231;
+  transaction.header[0] = 0x11;
+  transaction.headerLength = 1;
+  transaction.readData = registers;
+  transaction.readLength = 2;
+  if (run_TWI(&transaction) != DONE_TWI) return 0;
+  return (short)(int8_t)registers[0] * 4 + (registers[1] >> 6);
+}
+
+
+signed char readAgingOffset_DS3231() {
+  byte offset = 0;
+
+  Transaction_TWI transaction;
+  memset(&transaction, 0, sizeof(Transaction_TWI));
+  transaction.address = ADDRESS_DS3231;
+  transaction.header[0] = 0x10;
+  transaction.headerLength = 1;
+  transaction.readData = &offset;
+  transaction.readLength = 1;
+  run_TWI(&transaction);
+  return (signed char)offset;
+}
+
+
+void writeAgingOffset_DS3231(signed char offset) {
+  writeRegister_DS3231(0x10, (byte)offset);
+  // The offset takes effect at the next temperature conversion, start one (CONV) instead of waiting 64 s.
+  // Other bits are the same as startTick_DS3231() set.
+  writeRegister_DS3231(0x0E, 0b00100000);
+}
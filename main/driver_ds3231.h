@@ -0,0 +1,92 @@
+#ifndef DRIVER_DS3231_H
+#define DRIVER_DS3231_H
+
+
+/* Wire Connection for Arduino Nano:
+   RTC Module - Nano Board
+   VCC - 5V
+   GND - GND
+   SDA - A4 (I2C data)
+   SCL - A5 (I2C clock)
+   SQW - D2 (external interrupt INT0, open drain output, internal pull-up is used)
+   The AT24C32 on the same module shares the bus. */
+
+
+#include <Arduino.h>
+
+
+#define ADDRESS_DS3231 0b1101000
+#define SQW_PIN_DS3231 2 // must be an external interrupt pin, D2 or D3 on Nano
+
+
+/* Timekeeping registers 0x00-0x06 in their original BCD format and order,
+   so that one burst read fills the structure directly.
+   The driver keeps the RTC in 24-hour mode. */
+struct Time_DS3231 {
+  byte seconds; // 00-59
+  byte minutes; // 00-59
+  byte hours; // 00-23
+  byte day; // 1-7, day of week
+  byte date; // 01-31
+  byte month; // 01-12, bit 7 is century
+  byte year; // 00-99
+};
+
+byte bcdToDecimal_DS3231(byte bcd);
+byte decimalToBCD_DS3231(byte decimal);
+
+// Start I2C (driver_twi) and take the first snapshot of time.
+void initialize_DS3231();
+
+/* Read all seven timekeeping registers in one I2C burst into the snapshot.
+   Return false when the RTC didn't answer, the old snapshot is kept. */
+bool readTime_DS3231();
+
+/* Queue the same burst read and return immediately, the snapshot is replaced
+   by the TWI interrupt when the read completes (see takeTime_DS3231()).
+   Return false when a queued read hasn't finished yet. */
+bool requestTime_DS3231();
+
+// Return true once after every refresh of the snapshot, either by readTime or requestTime.
+bool takeTime_DS3231();
+
+/* Read the RTC only when at least one second elapsed since the last read.
+   Call it as often as you like, the I2C bus is used at most once a second.
+   Return true when the snapshot was refreshed. */
+bool updateTime_DS3231();
+
+/* Copy the snapshot into time, with seconds advanced by millis() elapsed since it was read.
+   Carry goes up to hours, the date is left to the next read. */
+void getTime_DS3231(Time_DS3231 *time);
+
+// Write time into the RTC and refresh the snapshot.
+void setTime_DS3231(const Time_DS3231 *time);
+
+/* Configure SQW/INT output as 1 Hz square wave and count its falling edges by interrupt.
+   Seconds register of RTC increments at the falling edge. */
+void startTick_DS3231();
+
+/* Return true once for every tick happened since the last call.
+   Ticks are not accumulated, a missed second is reported as one tick. */
+bool takeTick_DS3231();
+
+// micros() at the last falling edge of SQW, and when the last read of the time completed.
+unsigned long getTickMicros_DS3231();
+unsigned long getSnapshotMicros_DS3231();
+
+/* Put MCU into idle sleep until the next tick, return immediately if one is pending.
+   Idle mode keeps timers and SPI running for the display queue, and edge interrupts
+   on INT0/INT1 can't wake MCU from power-down. Other interrupts (millis) also wake it,
+   so call it in a loop. */
+void sleepUntilTick_DS3231();
+
+// Temperature in 0.25 degree Celsius steps, e.g. 94 means 23.5 C.
+short readTemperature_DS3231();
+
+/* Aging offset register (0x10) in two's complement, about 0.1 ppm per step at 25 C.
+   Positive values slow the oscillator down, negative values speed it up.
+   Writing it also starts a temperature conversion, so the new offset applies within a few ms. */
+signed char readAgingOffset_DS3231();
+void writeAgingOffset_DS3231(signed char offset);
+
+#endif
@@ -1,12 +1,121 @@
 #include <Arduino.h>
 #include <SPI.h>
 #include "driver_st7920.h"
+#include "profiler.h"
+#if defined(__AVR__)
+#include <avr/wdt.h>
+#endif
 
 
-volatile static char instructionSet_ST7920 = 'B'; // Current instruction set: 'B' - basic, 'E' - extended.
-volatile static bool displayStatus_ST7920 = true; // true - display ON, false - display OFF. (irrelevant to backlight).
-volatile static bool underlineCursorStatus_ST7920 = true; // true - show underline cursor, false - hide underline cursor.
-volatile static bool blinkCursorStatus_ST7920 = true; // true - show blink cursor, false - hide blink cursor.
+/* RST of the panel is tied to 3V3, so it keeps its RAM and registers across an MCU reset.
+   The state describing the panel is kept in .noinit, which the C runtime doesn't clear,
+   and initialize_ST7920() continues with it after a watchdog or reset button reset (warm start).
+   Such variables can't have initializers, the first initialization after reset sets them. */
+#if defined(__AVR__)
+#define RETAINED_ST7920 __attribute__((section(".noinit")))
+#else
+#define RETAINED_ST7920
+#endif
+
+volatile static char instructionSet_ST7920 RETAINED_ST7920; // Current instruction set: 'B' - basic, 'E' - extended.
+volatile static bool displayStatus_ST7920 RETAINED_ST7920; // true - display ON, false - display OFF. (irrelevant to backlight).
+volatile static bool underlineCursorStatus_ST7920 RETAINED_ST7920; // true - show underline cursor, false - hide underline cursor.
+volatile static bool blinkCursorStatus_ST7920 RETAINED_ST7920; // true - show blink cursor, false - hide blink cursor.
+volatile static bool graphicStatus_ST7920 RETAINED_ST7920; // true - graphic display (GDRAM) ON, false - graphic display OFF.
+volatile static byte reversedLines_ST7920 RETAINED_ST7920; // bit n set - line n (0-3) is shown reversed.
+volatile static bool frameOpen_ST7920 = false; // true - text updates are held until the frame ends.
+volatile static byte drawPage_ST7920 RETAINED_ST7920; // page written by print functions and framebuffer flush
+volatile static byte shownPage_ST7920 RETAINED_ST7920; // page selected by vertical scroll address
+volatile static byte framebufferPage_ST7920 RETAINED_ST7920; // page of GDRAM that the framebuffer was flushed to
+#define NO_CELL_ST7920 0xFF
+volatile static byte blinkCell_ST7920 RETAINED_ST7920; // cell of shown page kept under the blink cursor
+
+/* The retained state matches the panel when marker_ST7920 holds MARKER_ST7920 and no update is in progress.
+   Changes tracked by pending cells and dirty words are safe anyway, they are sent again after a reset,
+   updates_ST7920 counts the updates that change a register of the panel and its copy together. */
+#define MARKER_ST7920 0x57A9C0DEUL
+static unsigned long marker_ST7920 RETAINED_ST7920;
+volatile static byte updates_ST7920 RETAINED_ST7920;
+static bool started_ST7920 = false; // true - initialized since MCU reset
+
+struct Update_ST7920 {
+  Update_ST7920() { updates_ST7920 += 1; }
+  ~Update_ST7920() { updates_ST7920 -= 1; }
+};
+
+#if defined(__AVR__)
+/* MCUSR is saved before main() and cleared, so that the next reset shows only its own cause.
+   The watchdog keeps running after a watchdog reset until WDRF is cleared, so it's stopped here
+   as avr/wdt.h recommends, setup() of main.ino enables it again once everything is initialized. Bootloaders like optiboot clear
+   MCUSR themselves, then it reads 0 and the marker alone tells a warm start. */
+static byte resetCause_ST7920 RETAINED_ST7920;
+void saveResetCause_ST7920() __attribute__((naked, used, section(".init3")));
+void saveResetCause_ST7920() {
+  resetCause_ST7920 = MCUSR;
+  MCUSR = 0;
+  wdt_disable();
+}
+#endif
+
+/* Last instruction sent to each register of ST7920, 0 when unknown (no instruction is 0).
+   Setting a register to the value it already has is skipped. */
+#define ENTRY_MODE_ST7920 0
+#define DISPLAY_CONTROL_ST7920 1
+#define SCROLL_SELECT_ST7920 2 // extended set: vertical scroll address or CGRAM address
+#define REGISTERS_ST7920 3
+static short registers_ST7920[REGISTERS_ST7920] RETAINED_ST7920;
+
+/* Local copy of GDRAM, one bit per pixel, MSB is the leftmost pixel.
+   framebuffer_ST7920[y][x / 8] holds pixel (x, y), each row is WORDS_ST7920 GDRAM words.
+   dirtyWords_ST7920[y] bit n is set when word n of row y differs from what was flushed. */
+#define WORDS_ST7920 (WIDTH_ST7920 / 16) // GDRAM words in a pixel row
+#if WORDS_ST7920 > 8
+typedef unsigned short RowMask_ST7920;
+#else
+typedef byte RowMask_ST7920;
+#endif
+static byte framebuffer_ST7920[64][WIDTH_ST7920 / 8] RETAINED_ST7920;
+static RowMask_ST7920 dirtyWords_ST7920[64] RETAINED_ST7920;
+
+/* Local copy of the DDRAM shown on display, since it can't be read through SPI.
+   It's indexed by half character position (row * COLUMNS_ST7920 + column), so that
+   full character (cell) n holds ddram_ST7920[page][2n] (left) and ddram_ST7920[page][2n + 1] (right).
+   Page 1 is the DDRAM area 32-63 which is hidden on 128*64 display unless scrolled to.
+   pendingCells_ST7920 holds one bit for each cell of draw page changed in local copy but not sent yet. */
+static byte ddram_ST7920[PAGES_ST7920][POSITIONS_ST7920 * 2] RETAINED_ST7920;
+static byte pendingCells_ST7920[POSITIONS_ST7920 / 8] RETAINED_ST7920;
+
+
+#define SOFTWARE_CLOCK_ST7920 625000 // software clock is never faster than 800 ns high + 800 ns low
+#define DATA_EXECUTION_TIME_ST7920 72 // us to write one byte into DDRAM/CGRAM/GDRAM
+
+/* Timing set by setTiming_ST7920(), SPI_CLOCK_ST7920 and no slack by default.
+   Transfer times are rounded down, so they never shorten a wait below the execution time. */
+static unsigned long requestedClock_ST7920 = SPI_CLOCK_ST7920; // Hz asked for
+static unsigned long bitClock_ST7920; // Hz actually clocked out
+static byte slack_ST7920 = 0; // us added to every execution time
+static unsigned short transferTime_ST7920; // us to clock out 3 bytes
+static unsigned short dataTransferTime_ST7920; // us to clock out 2 bytes of data without sync
+#define SYNC_DATA_ST7920 0b11111010 // synchronizing bit string with RW = 0, RS = 1
+
+
+/* Execution time (us) of instructions according to datasheet.
+   Column n (0-7) is the instruction whose highest set bit is DBn, column 8 is RAM data write.
+   Row 0 is basic instruction set, row 1 is extended instruction set.
+   Only display clear (DB0) and return home (DB1) in basic set need 1.6 ms. */
+static const unsigned short executionTimes_ST7920[2][9] PROGMEM = {
+  {1600, 1600, 72, 72, 72, 72, 72, 72, 72},
+  {72, 72, 72, 72, 72, 72, 72, 72, 72}};
+
+
+static unsigned short executionTime_ST7920(short instruction) {
+  byte column = 8;
+  if (!(instruction & 0b1000000000)) {
+    column = 7;
+    while (column > 0 && !(instruction & (1 << column))) column--;
+  }
+  return pgm_read_word(&executionTimes_ST7920[instructionSet_ST7920 == 'E'][column]);
+}
 
 
 /* Instruction structure is same to that in datasheet:
@@ -15,14 +124,219 @@ volatile static bool blinkCursorStatus_ST7920 = true; // true - show blink curso
    (byte 1) 1 1 1 1 RW RS 0;
    (byte 2) DB7 DB6 DB5 DB4 0 0 0 0;
    (byte 3) DB3 DB2 DB1 DB0 0 0 0 0. */
+static void encodeInstruction_ST7920(short instruction, byte bytes[3]) {
+  bytes[0] = (instruction >> 8 & 0b0000000010) |
+             (instruction >> 6 & 0b0000000100) | 0b11111000;
+  bytes[1] = instruction & 0b0011110000;
+  bytes[2] = instruction << 4 & 0b0011110000;
+}
+
+
+#if EXTERNAL_TRANSPORT_ST7920
+
+#if ASYNC_ST7920
+#error "ASYNC_ST7920 needs hardware SPI, set it to false when EXTERNAL_TRANSPORT_ST7920 is true."
+#endif
+
+// The transport is expected to take the time the clock of setTiming_ST7920() needs for 8 bits.
+static inline void transferByte_ST7920(byte data) {
+  PROBE_PROFILER(SPI_TRANSFER_PROFILER);
+  transferByteExternal_ST7920(data);
+}
+
+#elif SOFTWARE_SPI_ST7920
+
+#if ASYNC_ST7920
+#error "ASYNC_ST7920 needs hardware SPI, set it to false when SOFTWARE_SPI_ST7920 is true."
+#endif
+
+#define PULSE_CYCLES_ST7920 ((800UL * (F_CPU / 1000000UL) + 999) / 1000) // CPU cycles in 800 ns
+
+// Output registers and bit masks of SID and SCLK, looked up once in initialization.
+static volatile uint8_t *sidPort_ST7920;
+static volatile uint8_t *sclkPort_ST7920;
+static uint8_t sidMask_ST7920;
+static uint8_t sclkMask_ST7920;
+
+
+/* Same as SPI_MODE3 and MSBFIRST: SCLK is idle when high and SID is captured when SCLK rises.
+   Port registers are written directly since digitalWrite takes several microseconds.
+   Interrupts are disabled within a byte, an interrupt routine may write the same port. */
+static void transferByte_ST7920(byte data) {
+  PROBE_PROFILER(SPI_TRANSFER_PROFILER);
+  byte oldSREG = SREG;
+  cli();
+  for (byte mask = 0b10000000; mask; mask >>= 1) {
+    *sclkPort_ST7920 &= ~sclkMask_ST7920;
+    if (data & mask) *sidPort_ST7920 |= sidMask_ST7920;
+    else *sidPort_ST7920 &= ~sidMask_ST7920;
+    __builtin_avr_delay_cycles(PULSE_CYCLES_ST7920);
+    *sclkPort_ST7920 |= sclkMask_ST7920;
+    __builtin_avr_delay_cycles(PULSE_CYCLES_ST7920);
+  }
+  SREG = oldSREG;
+}
+
+#else
+
+static inline void transferByte_ST7920(byte data) {
+  PROBE_PROFILER(SPI_TRANSFER_PROFILER);
+  SPI.transfer(data);
+}
+
+#endif
+
+
+#if ASYNC_ST7920
+
+/* Instructions waiting to be sent by interrupts.
+   SPI transfer complete interrupt pushes the 3 bytes of an instruction one by one,
+   then Timer2 (prescaler 128, 8 us per tick at 16 MHz) counts the remaining execution time
+   and its compare match interrupt starts the next instruction. */
+#define QUEUE_SIZE_ST7920 32 // power of 2 and no more than 128, so that byte indices wrap correctly
+#define TIMER_TICK_ST7920 (128 * 1000000UL / F_CPU) // us per Timer2 tick
+
+struct QueuedInstruction_ST7920 {
+  byte bytes[3]; // encoded instruction, bytes[0] is 0 when the synchronizing byte is skipped
+  byte waitTicks; // Timer2 ticks to wait after the transfer
+};
+
+static QueuedInstruction_ST7920 queue_ST7920[QUEUE_SIZE_ST7920];
+volatile static byte queueHead_ST7920 = 0; // index of the instruction being sent
+volatile static byte queueTail_ST7920 = 0; // index of the next free slot
+volatile static byte transferStep_ST7920 = 0; // number of bytes of current instruction given to SPI
+volatile static bool queueRunning_ST7920 = false; // true - interrupts are working on the queue
+volatile static bool queueFilled_ST7920 RETAINED_ST7920; // same, but survives a reset in the middle of the queue
+volatile static unsigned long idleMicros_ST7920 = 0; // micros() when the queue ran empty last time
+
+
+// Must be called with interrupts disabled.
+static void startNextInstruction_ST7920() {
+  if (queueHead_ST7920 == queueTail_ST7920) {
+    queueRunning_ST7920 = false;
+    queueFilled_ST7920 = false;
+    idleMicros_ST7920 = micros();
+    return;
+  }
+  queueRunning_ST7920 = true;
+  queueFilled_ST7920 = true;
+  QueuedInstruction_ST7920 *next = &queue_ST7920[queueHead_ST7920 % QUEUE_SIZE_ST7920];
+  if (next->bytes[0]) {
+    transferStep_ST7920 = 1;
+    SPDR = next->bytes[0];
+  } else {
+    transferStep_ST7920 = 2; // data following another data write, synchronizing byte is skipped
+    SPDR = next->bytes[1];
+  }
+}
+
+
+ISR(SPI_STC_vect) {
+  QueuedInstruction_ST7920 *current = &queue_ST7920[queueHead_ST7920 % QUEUE_SIZE_ST7920];
+
+  if (transferStep_ST7920 < 3) {
+    SPDR = current->bytes[transferStep_ST7920];
+    transferStep_ST7920 += 1;
+  } else if (current->waitTicks > 0) {
+    TCNT2 = 0;
+    OCR2A = current->waitTicks - 1;
+    TIFR2 = _BV(OCF2A);
+    /* The prescaler keeps counting while Timer2 is stopped, so without a reset the first tick comes
+       0-8 us after start and the wait is up to one tick short. PSRASY only resets the Timer2 prescaler. */
+    GTCCR = _BV(PSRASY);
+    TCCR2B = _BV(CS22) | _BV(CS20); // start Timer2 with prescaler 128
+  } else {
+    queueHead_ST7920 += 1;
+    startNextInstruction_ST7920();
+  }
+}
+
+
+ISR(TIMER2_COMPA_vect) {
+  TCCR2B = 0; // stop Timer2, it is a one-shot delay
+  queueHead_ST7920 += 1;
+  startNextInstruction_ST7920();
+}
+
+
+static byte waitTicks_ST7920(unsigned short executionTime, unsigned short transferTime) {
+  if (executionTime <= transferTime) return 0;
+  return (executionTime - transferTime + TIMER_TICK_ST7920 - 1) / TIMER_TICK_ST7920;
+}
+
+
+/* Put encoded bytes into queue and return immediately unless the queue is full.
+   Do not call it with interrupts disabled, otherwise a full queue never drains. */
+static void enqueue_ST7920(byte first, byte second, byte third, byte waitTicks) {
+  while ((byte)(queueTail_ST7920 - queueHead_ST7920) >= QUEUE_SIZE_ST7920); // wait for a free slot
+
+  QueuedInstruction_ST7920 *slot = &queue_ST7920[queueTail_ST7920 % QUEUE_SIZE_ST7920];
+  slot->bytes[0] = first;
+  slot->bytes[1] = second;
+  slot->bytes[2] = third;
+  slot->waitTicks = waitTicks;
+
+  byte oldSREG = SREG;
+  cli();
+  queueTail_ST7920 += 1;
+  if (!queueRunning_ST7920) startNextInstruction_ST7920();
+  SREG = oldSREG;
+}
+
+
 static void sendInstruction_ST7920(short instruction) {
-  SPI.transfer((instruction >> 8 & 0b0000000010) |
-               (instruction >> 6 & 0b0000000100) | 0b11111000);
-  SPI.transfer(instruction & 0b0011110000);
-  SPI.transfer(instruction << 4 & 0b0011110000);
-  delayMicroseconds(80);
+  PROBE_PROFILER(SEND_INSTRUCTION_PROFILER);
+  byte bytes[3];
+  encodeInstruction_ST7920(instruction, bytes);
+  enqueue_ST7920(bytes[0], bytes[1], bytes[2],
+                 waitTicks_ST7920(executionTime_ST7920(instruction) + slack_ST7920, transferTime_ST7920));
+}
+
+
+/* Write a run of bytes into DDRAM/CGRAM/GDRAM at the address counter.
+   ST7920 keeps RS = 1 after one synchronizing byte, so only the first byte carries it
+   and each of the others is sent as two nibble bytes. */
+static void sendData_ST7920(const byte data[], byte length) {
+  PROBE_PROFILER(SEND_DATA_PROFILER);
+  byte waitTicks = waitTicks_ST7920(DATA_EXECUTION_TIME_ST7920 + slack_ST7920, dataTransferTime_ST7920);
+  for (byte i = 0; i < length; i++)
+    enqueue_ST7920(i == 0 ? SYNC_DATA_ST7920 : 0, data[i] & 0b11110000, data[i] << 4, waitTicks);
 }
 
+#else
+
+/* Transfer of 24 bits already takes part of the execution time,
+   so only the remaining time is waited after the transfer. */
+static void sendInstruction_ST7920(short instruction) {
+  PROBE_PROFILER(SEND_INSTRUCTION_PROFILER);
+  byte bytes[3];
+  encodeInstruction_ST7920(instruction, bytes);
+  transferByte_ST7920(bytes[0]);
+  transferByte_ST7920(bytes[1]);
+  transferByte_ST7920(bytes[2]);
+  unsigned short executionTime = executionTime_ST7920(instruction) + slack_ST7920;
+  if (executionTime > transferTime_ST7920) delayMicroseconds(executionTime - transferTime_ST7920);
+}
+
+
+/* Write a run of bytes into DDRAM/CGRAM/GDRAM at the address counter.
+   ST7920 keeps RS = 1 after one synchronizing byte, so only the first byte carries it
+   and each byte costs 16 bits instead of 24. The bytes can't be pushed in one buffer
+   transfer because ST7920 has no input buffer and needs 72 us to execute each write. */
+static void sendData_ST7920(const byte data[], byte length) {
+  PROBE_PROFILER(SEND_DATA_PROFILER);
+  if (length == 0) return;
+  unsigned short executionTime = DATA_EXECUTION_TIME_ST7920 + slack_ST7920;
+  transferByte_ST7920(SYNC_DATA_ST7920);
+  for (byte i = 0; i < length; i++) {
+    transferByte_ST7920(data[i] & 0b11110000);
+    transferByte_ST7920(data[i] << 4);
+    if (executionTime > dataTransferTime_ST7920) delayMicroseconds(executionTime - dataTransferTime_ST7920);
+  }
+}
+
+#endif
+
 
 /* Provide 'E' to select "extended instruction" set.
    Provide 'B' to select "basic instruction" set.
@@ -30,7 +344,8 @@ static void sendInstruction_ST7920(short instruction) {
 static void chooseInstructionSet_ST7920(char choice) {
   if (choice == 'E' and instructionSet_ST7920 == 'B') {
     instructionSet_ST7920 = 'E';
-    sendInstruction_ST7920(0b0000110100);
+    // G stays latched while RE changes, so G is sent as it already is and the graphic display stays on.
+    sendInstruction_ST7920(graphicStatus_ST7920 ? 0b0000110110 : 0b0000110100);
   } else if (choice == 'B' and instructionSet_ST7920 == 'E') {
     instructionSet_ST7920 = 'B';
     sendInstruction_ST7920(0b0000110000);
@@ -38,16 +353,26 @@ static void chooseInstructionSet_ST7920(char choice) {
 }
 
 
+/* Send the instruction in the given instruction set ('B' or 'E'),
+   unless the register already holds the same value. */
+static void sendRegister_ST7920(byte index, char choice, short instruction) {
+  if (registers_ST7920[index] == instruction) return;
+  Update_ST7920 update;
+  registers_ST7920[index] = instruction;
+  chooseInstructionSet_ST7920(choice);
+  sendInstruction_ST7920(instruction);
+}
+
+
 /* mode = 'C': cursor moves after writing a character
    mode = 'D': display shifts after writing a character
    direction = 'L': cursor or display moves left
    direction = 'R': cursor or display moves right */
 static void setEntryMode_ST7920(char mode, char direction) {
-  chooseInstructionSet_ST7920('B');
-  if (mode == 'C' and direction == 'R') sendInstruction_ST7920(0b0000000110);
-  else if (mode == 'C' and direction == 'L') sendInstruction_ST7920(0b0000000100);
-  else if (mode == 'D' and direction == 'R') sendInstruction_ST7920(0b0000000101);
-  else if (mode == 'D' and direction == 'L') sendInstruction_ST7920(0b0000000111);
+  if (mode == 'C' and direction == 'R') sendRegister_ST7920(ENTRY_MODE_ST7920, 'B', 0b0000000110);
+  else if (mode == 'C' and direction == 'L') sendRegister_ST7920(ENTRY_MODE_ST7920, 'B', 0b0000000100);
+  else if (mode == 'D' and direction == 'R') sendRegister_ST7920(ENTRY_MODE_ST7920, 'B', 0b0000000101);
+  else if (mode == 'D' and direction == 'L') sendRegister_ST7920(ENTRY_MODE_ST7920, 'B', 0b0000000111);
 }
 
 
@@ -78,118 +403,678 @@ static void homeCursor_ST7920() {
 }
 
 
+/* DDRAM address of each full character position (cursor position), see the note at the end of this file.
+   Lines of 128*64 display are interleaved, those of 256*64 display follow each other. */
+#if WIDTH_ST7920 == 256
+static const byte cursorAddresses_ST7920[POSITIONS_ST7920] PROGMEM = {
+  0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15,
+  16, 17, 18, 19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29, 30, 31,
+  32, 33, 34, 35, 36, 37, 38, 39, 40, 41, 42, 43, 44, 45, 46, 47,
+  48, 49, 50, 51, 52, 53, 54, 55, 56, 57, 58, 59, 60, 61, 62, 63};
+#else
+static const byte cursorAddresses_ST7920[POSITIONS_ST7920] PROGMEM = {
+  0, 1, 2, 3, 4, 5, 6, 7,
+  16, 17, 18, 19, 20, 21, 22, 23,
+  8, 9, 10, 11, 12, 13, 14, 15,
+  24, 25, 26, 27, 28, 29, 30, 31};
+#endif
+
+
+static byte cursorAddress_ST7920(byte position) {
+  return pgm_read_byte(&cursorAddresses_ST7920[position]);
+}
+
+
 /* Correctly set the cursor position according to cursor change pattern.
-   32 full sized 16*16 characters can be presented by 128*64 display at the same time.
-   The position is a number between 0 (top left corner) and 31 (bottom right corner). */
+   32 (64) full sized 16*16 characters can be presented by 128*64 (256*64) display at the same time.
+   The position is a number between 0 (top left corner) and POSITIONS_ST7920 - 1 (bottom right corner). */
 static void setCursor_ST7920(byte position) {
-  if ((position >= 0 && position <= 7) || (position >= 24 && position <= 31)) {
-    sendInstruction_ST7920(0b0010000000 | position);
-  } else if (position >= 8 && position <= 15) {
-    sendInstruction_ST7920(0b0010000000 | position + 8);
-  } else if (position >= 16 && position <= 23) {
-    sendInstruction_ST7920(0b0010000000 | position - 8);
+  PROBE_PROFILER(SET_CURSOR_PROFILER);
+  if (position >= POSITIONS_ST7920) return;
+  chooseInstructionSet_ST7920('B'); // the same instruction sets GDRAM address in extended set
+  sendInstruction_ST7920(0b0010000000 | (drawPage_ST7920 * POSITIONS_ST7920 + cursorAddress_ST7920(position)));
+}
+
+
+/* Data writes and clear move the address counter, and the blink cursor follows it.
+   Put it back on the blinking cell, if there is one. */
+static void restoreBlinkCursor_ST7920() {
+  if (blinkCell_ST7920 == NO_CELL_ST7920) return;
+  chooseInstructionSet_ST7920('B');
+  sendInstruction_ST7920(0b0010000000 | (shownPage_ST7920 * POSITIONS_ST7920 + cursorAddress_ST7920(blinkCell_ST7920)));
+}
+
+
+/* Set GDRAM address in extended instruction set.
+   The upper half (row 0-31) of 128*64 display is word 0-7 of GDRAM row 0-31,
+   the lower half (row 32-63) is word 8-15 of the same GDRAM rows.
+   Page 1 of 128*64 display is GDRAM row 32-63 in the same way.
+   Rows of 256*64 display are GDRAM rows 0-63 directly.
+   row (0-63): pixel row. word (0 to WORDS_ST7920 - 1): 16 pixels wide horizontal word. */
+static void setGraphicCursor_ST7920(byte row, byte word) {
+  chooseInstructionSet_ST7920('E');
+#if WIDTH_ST7920 == 128
+  if (row >= 32) {
+    row -= 32;
+    word += 8;
   }
+  row += drawPage_ST7920 * 32;
+#endif
+  sendInstruction_ST7920(0b0010000000 | row); // vertical address first
+  sendInstruction_ST7920(0b0010000000 | word); // then horizontal address
+}
+
+
+/* Store a character code at half character position of the local DDRAM copy,
+   its cell is marked pending if the content changed. */
+static void storeCharacter_ST7920(byte position, byte code) {
+  byte *page = ddram_ST7920[drawPage_ST7920];
+  if (page[position] == code) return;
+  pendingCells_ST7920[position / 16] |= 1 << (position / 2 % 8); // marked first, in case of a reset in between
+  page[position] = code;
+}
+
+
+static bool isCellPending_ST7920(byte cell) {
+  return pendingCells_ST7920[cell / 8] & 1 << (cell % 8);
+}
+
+
+/* Cell (full character position) shown at a DDRAM address of the draw page, inverse of cursorAddress_ST7920.
+   On 128*64 display, address 8-15 (latter half of line 0) is line 2 and 16-23 is line 1. */
+static byte cellOfAddress_ST7920(byte address) {
+#if WIDTH_ST7920 == 128
+  return (address % 16 / 8 * 2 + address / 16) * 8 + address % 8;
+#else
+  return address;
+#endif
 }
 
 
-void initialize_ST7920() {
+/* Send the pending cells from the local DDRAM copy.
+   Cells are visited in DDRAM address order, so each run of changed cells with consecutive
+   addresses costs one cursor set, even where it goes on in another line of the display
+   (line 0 then line 2, line 1 then line 3 on 128*64). */
+static void flushCells_ST7920() {
+  PROBE_PROFILER(FLUSH_CELLS_PROFILER);
+  byte address = 0;
+  bool sent = false;
+  while (address < POSITIONS_ST7920) {
+    if (!isCellPending_ST7920(cellOfAddress_ST7920(address))) {
+      address += 1;
+      continue;
+    }
+    byte first = address;
+    do {
+      address += 1;
+    } while (address < POSITIONS_ST7920 && isCellPending_ST7920(cellOfAddress_ST7920(address)));
+    setCursor_ST7920(cellOfAddress_ST7920(first));
+    sent = true;
+
+    // Send the run in pieces that are contiguous in the local copy, the address counter goes on by itself.
+    for (byte piece = first; piece < address;) {
+      byte cell = cellOfAddress_ST7920(piece);
+      byte count = 1;
+      while (piece + count < address && cellOfAddress_ST7920(piece + count) == cell + count) count++;
+      sendData_ST7920(&ddram_ST7920[drawPage_ST7920][cell * 2], count * 2);
+      piece += count;
+    }
+  }
+  memset(pendingCells_ST7920, 0, sizeof(pendingCells_ST7920));
+  if (sent) restoreBlinkCursor_ST7920();
+}
+
+
+/* Display control instruction according to global variables defined at the beginning. */
+static void sendDisplayControl_ST7920() {
+  short instruction = 0b0000001000;
+  if (displayStatus_ST7920) instruction |=  0b0000000100;
+  if (underlineCursorStatus_ST7920) instruction |= 0b0000000010;
+  if (blinkCursorStatus_ST7920) instruction |= 0b0000000001;
+  sendRegister_ST7920(DISPLAY_CONTROL_ST7920, 'B', instruction);
+}
+
+
+/* Hardware SPI divides the CPU clock by a power of 2 (2 to 128),
+   SPISettings picks the fastest that isn't above the requested clock. */
+static unsigned long actualClock_ST7920(unsigned long clock) {
+#if EXTERNAL_TRANSPORT_ST7920
+  return clock;
+#elif SOFTWARE_SPI_ST7920
+  return SOFTWARE_CLOCK_ST7920;
+#else
+  unsigned long actual = F_CPU / 2;
+  while (actual > clock && actual > F_CPU / 128) actual /= 2;
+  return actual;
+#endif
+}
+
+
+void setTiming_ST7920(unsigned long clock, byte slack) {
+  requestedClock_ST7920 = clock;
+  slack_ST7920 = slack;
+}
+
+
+unsigned long getClock_ST7920() {
+  return bitClock_ST7920;
+}
+
+
+byte getSlack_ST7920() {
+  return slack_ST7920;
+}
+
+
+/* A reset (watchdog, reset button) that left the panel powered and the retained state valid. */
+static bool isWarmStart_ST7920() {
+#if defined(__AVR__)
+  if (resetCause_ST7920 & (_BV(PORF) | _BV(BORF))) return false; // the panel lost power too
+#endif
+#if ASYNC_ST7920
+  if (queueFilled_ST7920) return false; // instructions queued before the reset were lost
+#endif
+  return marker_ST7920 == MARKER_ST7920 && updates_ST7920 == 0;
+}
+
+
+bool initialize_ST7920() {
+  // SPI clock, Timer2 and transfer times change below, let the queue finish at the old timing.
+  if (started_ST7920) waitUntilIdle_ST7920();
+
+  bitClock_ST7920 = actualClock_ST7920(requestedClock_ST7920);
+  transferTime_ST7920 = 24 * 1000000UL / bitClock_ST7920;
+  dataTransferTime_ST7920 = 16 * 1000000UL / bitClock_ST7920;
+
+#if EXTERNAL_TRANSPORT_ST7920
+  // Nothing to set up, the transport is ready.
+#elif SOFTWARE_SPI_ST7920
+  // Chip select is active high, SCLK is idle when high.
+  pinMode(CS_PIN_ST7920, OUTPUT);
+  pinMode(SID_PIN_ST7920, OUTPUT);
+  pinMode(SCLK_PIN_ST7920, OUTPUT);
+  digitalWrite(CS_PIN_ST7920, HIGH);
+  digitalWrite(SCLK_PIN_ST7920, HIGH);
+  sidPort_ST7920 = portOutputRegister(digitalPinToPort(SID_PIN_ST7920));
+  sclkPort_ST7920 = portOutputRegister(digitalPinToPort(SCLK_PIN_ST7920));
+  sidMask_ST7920 = digitalPinToBitMask(SID_PIN_ST7920);
+  sclkMask_ST7920 = digitalPinToBitMask(SCLK_PIN_ST7920);
+#else
   // Activate and config SPI communication.
   SPI.begin();
-  SPI.beginTransaction(SPISettings(600000, MSBFIRST, SPI_MODE3));
+  SPI.beginTransaction(SPISettings(requestedClock_ST7920, MSBFIRST, SPI_MODE3));
+#endif
+
+#if ASYNC_ST7920
+  // Timer2 in CTC mode as one-shot execution time delay, it's started by SPI interrupt.
+  TCCR2A = _BV(WGM21);
+  TCCR2B = 0;
+  TIMSK2 = _BV(OCIE2A);
+  SPI.attachInterrupt();
+#endif
+
+  bool warm = !started_ST7920 && isWarmStart_ST7920();
+  if (warm) {
+    // Display shows the last frame already, send function set and display control again
+    // in case the reset came between changing them and sending them.
+    started_ST7920 = true;
+    instructionSet_ST7920 = 'B';
+    sendInstruction_ST7920(0b0000110000);
+    if (graphicStatus_ST7920) {
+      chooseInstructionSet_ST7920('E');
+      chooseInstructionSet_ST7920('B');
+    }
+    registers_ST7920[DISPLAY_CONTROL_ST7920] = 0;
+    sendDisplayControl_ST7920();
+    restoreBlinkCursor_ST7920();
+    return true;
+  }
+
+  marker_ST7920 = 0;
+  updates_ST7920 = 0;
+#if ASYNC_ST7920
+  if (!queueRunning_ST7920) queueFilled_ST7920 = false;
+#endif
+  if (!started_ST7920) {
+    // Defaults and empty framebuffer, as they were before the state was retained.
+    started_ST7920 = true;
+    displayStatus_ST7920 = true;
+    underlineCursorStatus_ST7920 = true;
+    blinkCursorStatus_ST7920 = true;
+    framebufferPage_ST7920 = 0;
+    memset(framebuffer_ST7920, 0, sizeof(framebuffer_ST7920));
+    memset(dirtyWords_ST7920, 0, sizeof(dirtyWords_ST7920));
+  }
 
-  // Choose basic function set.
+  // Choose basic function set, state of every register is unknown now.
+  memset(registers_ST7920, 0, sizeof(registers_ST7920));
   instructionSet_ST7920 = 'B';
   sendInstruction_ST7920(0b0000110000);
-  delayMicroseconds(20);
+
+  // Graphic display is not affected by basic function set, turn it off explicitly.
+  graphicStatus_ST7920 = false;
+  chooseInstructionSet_ST7920('E');
+  chooseInstructionSet_ST7920('B');
 
   // set display status according to global variables defined at the beginning.
-  short displayControl = 0b0000001000;
-  if (displayStatus_ST7920) displayControl |=  0b0000000100;
-  if (underlineCursorStatus_ST7920) displayControl |= 0b0000000010;
-  if (blinkCursorStatus_ST7920) displayControl |= 0b0000000001;
-  sendInstruction_ST7920(displayControl);
-  delayMicroseconds(20);
+  sendDisplayControl_ST7920();
 
   // Clear display content.
   sendInstruction_ST7920(0b0000000001);
-  delay(10);
+  memset(ddram_ST7920, ' ', sizeof(ddram_ST7920)); // display clear fills DDRAM with spaces
+  memset(pendingCells_ST7920, 0, sizeof(pendingCells_ST7920));
+  reversedLines_ST7920 = 0;
+  blinkCell_ST7920 = NO_CELL_ST7920;
+  drawPage_ST7920 = 0;
+  shownPage_ST7920 = 0;
 
   // set entry mode: cursor moves right
-  sendInstruction_ST7920(0b0000000110);
+  setEntryMode_ST7920('C', 'R');
+  marker_ST7920 = MARKER_ST7920;
+  return false;
+}
+
+
+bool isBusy_ST7920() {
+#if ASYNC_ST7920
+  return queueRunning_ST7920;
+#else
+  return false;
+#endif
+}
+
+
+unsigned long getIdleMicros_ST7920() {
+#if ASYNC_ST7920
+  byte oldSREG = SREG;
+  cli();
+  unsigned long idle = idleMicros_ST7920;
+  SREG = oldSREG;
+  return idle;
+#else
+  return micros(); // every transfer has finished by the time a function returns
+#endif
+}
+
+
+void waitUntilIdle_ST7920() {
+  while (isBusy_ST7920());
 }
 
 
 void clearCharacterDisplay_ST7920() {
+  Update_ST7920 update;
   chooseInstructionSet_ST7920('B');
   sendInstruction_ST7920(0b0000000001);
-  delay(2);
+  memset(ddram_ST7920, ' ', sizeof(ddram_ST7920));
+  memset(pendingCells_ST7920, 0, sizeof(pendingCells_ST7920));
+  restoreBlinkCursor_ST7920();
 }
 
 
-void setDisplayStatus_ST7920(char option, bool status) {
-  short instruction = 0b0000001000;
+void setDisplay_ST7920(bool status) {
+  displayStatus_ST7920 = status;
+  sendDisplayControl_ST7920();
+}
 
-  switch (option) {
-    case 'D':
-      displayStatus_ST7920 = status;
-      break;
-    case 'C':
-      underlineCursorStatus_ST7920 = status;
-      break;
-    case 'B':
-      blinkCursorStatus_ST7920 = status;
-      break;
-  }
 
-  if (displayStatus_ST7920) instruction |=  0b0000000100;
-  if (underlineCursorStatus_ST7920) instruction |= 0b0000000010;
-  if (blinkCursorStatus_ST7920) instruction |= 0b0000000001;
+void setUnderlineCursor_ST7920(bool status) {
+  underlineCursorStatus_ST7920 = status;
+  sendDisplayControl_ST7920();
+}
+
 
+void setBlinkCursor_ST7920(bool status) {
+  blinkCursorStatus_ST7920 = status;
+  sendDisplayControl_ST7920();
+}
+
+
+void setGraphicDisplay_ST7920(bool status) {
+  if (graphicStatus_ST7920 == status) return;
+  chooseInstructionSet_ST7920('E');
+  graphicStatus_ST7920 = status;
+  sendInstruction_ST7920(status ? 0b0000110110 : 0b0000110100);
+}
+
+
+void setLineReverse_ST7920(byte line, bool status) {
+  if (line > 3 || (bool)(reversedLines_ST7920 & 1 << line) == status) return;
+  Update_ST7920 update;
+  reversedLines_ST7920 ^= 1 << line;
+  chooseInstructionSet_ST7920('E');
+  sendInstruction_ST7920(0b0000000100 | line); // each reverse instruction toggles the line
+}
+
+
+void setGlyph_ST7920(byte slot, const byte bitmap[]) {
+  if (slot > 3) return;
+  sendRegister_ST7920(SCROLL_SELECT_ST7920, 'E', 0b0000000010); // SR = 0: allow setting CGRAM address
   chooseInstructionSet_ST7920('B');
-  sendInstruction_ST7920(instruction);
+  sendInstruction_ST7920(0b0001000000 | slot * 16); // each glyph takes 16 words of CGRAM
+  sendData_ST7920(bitmap, 32);
+  restoreBlinkCursor_ST7920();
 }
 
 
-void printHalfCharacters_ST7920(char chars[], byte length, byte row, byte column) {
-  byte position = row * 16 + column; // range of position for half chars is 0-63
-  setCursor_ST7920(position / 2); // move cursor to specified position
+void setBlinkCell_ST7920(byte row, byte column) {
+  if (row >= 4 || column >= COLUMNS_ST7920 / 2) return; // a column past the line would land on the next one
+  byte cell = row * (COLUMNS_ST7920 / 2) + column;
+  if (cell != blinkCell_ST7920) {
+    blinkCell_ST7920 = cell;
+    restoreBlinkCursor_ST7920();
+  }
+  setBlinkCursor_ST7920(true);
+}
 
-  if (position % 2 == 1) sendInstruction_ST7920(0b1000100000); // add a space at the beginning when needed
-  for (byte i = 0; i < length; i++) {
-    if (position == 16 || position == 32 || position == 48)
-      setCursor_ST7920(position / 2); // move to the next line by set cursor on appropriate position on the display module
-    sendInstruction_ST7920(0b1000000000 | chars[i]);
-    position += 1;
+
+void stopBlink_ST7920() {
+  blinkCell_ST7920 = NO_CELL_ST7920;
+  setBlinkCursor_ST7920(false);
+}
+
+
+bool isGlyphShown_ST7920(byte slot) {
+  for (byte cell = 0; cell < POSITIONS_ST7920; cell++)
+    for (byte page = 0; page < PAGES_ST7920; page++)
+      if (ddram_ST7920[page][cell * 2] == 0x00 && ddram_ST7920[page][cell * 2 + 1] == slot * 2) return true;
+  return false;
+}
+
+
+void setDrawPage_ST7920(byte page) {
+  if (page >= PAGES_ST7920 || page == drawPage_ST7920) return;
+  flushCells_ST7920(); // pending cells belong to the old page
+  drawPage_ST7920 = page;
+}
+
+
+void showPage_ST7920(byte page) {
+  if (page >= PAGES_ST7920 || page == shownPage_ST7920) return;
+  Update_ST7920 update;
+  sendRegister_ST7920(SCROLL_SELECT_ST7920, 'E', 0b0000000011); // SR = 1: allow setting vertical scroll address
+  chooseInstructionSet_ST7920('E');
+  sendInstruction_ST7920(0b0001000000 | page * 32); // scroll by 32 pixel rows shows page 1
+  shownPage_ST7920 = page;
+  restoreBlinkCursor_ST7920(); // the blinking cell is on the shown page
+}
+
+
+void flipPages_ST7920() {
+  if (!frameOpen_ST7920) flushCells_ST7920();
+  byte drawn = drawPage_ST7920;
+  setDrawPage_ST7920(shownPage_ST7920);
+  showPage_ST7920(drawn);
+}
+
+
+void beginFrame_ST7920() {
+  frameOpen_ST7920 = true;
+}
+
+
+void endFrame_ST7920() {
+  frameOpen_ST7920 = false;
+
+  // Start with the group that the current instruction set belongs to,
+  // so that a frame mixing text and graphics switches instruction set at most once.
+  if (instructionSet_ST7920 == 'E') {
+    flushFramebuffer_ST7920();
+    flushCells_ST7920();
+  } else {
+    flushCells_ST7920();
+    flushFramebuffer_ST7920();
   }
-  if (position % 2 == 1) sendInstruction_ST7920(0b1000100000); // add a space at the end when needed
 }
 
 
-void printFullCharacters_ST7920(short chars[], byte length, byte row, byte column) {
-  byte position = row * 8 + column;
-  setCursor_ST7920(position);
+void clearFramebuffer_ST7920() {
+  memset(framebuffer_ST7920, 0, sizeof(framebuffer_ST7920));
+  memset(dirtyWords_ST7920, 0b11111111, sizeof(dirtyWords_ST7920)); // GDRAM content is unknown after power on
+}
 
-  for (byte i = 0; i < length; i++) {
-    if (position == 8 || position == 16 || position == 24)
-      setCursor_ST7920(position);
-    sendInstruction_ST7920(0b1000000000 | chars[i] >> 8 & 0b0000000011111111);
-    sendInstruction_ST7920(0b1000000000 | chars[i] & 0b0000000011111111);
-    position += 1;
+
+void drawPixel_ST7920(unsigned short x, byte y, bool color) {
+  if (x >= WIDTH_ST7920 || y >= 64) return;
+  byte *target = &framebuffer_ST7920[y][x / 8];
+  byte mask = 0b10000000 >> (x % 8);
+  byte updated = color ? *target | mask : *target & ~mask;
+  if (updated == *target) return;
+  dirtyWords_ST7920[y] |= (RowMask_ST7920)1 << (x / 16);
+  *target = updated;
+}
+
+
+/* Masks cover the part of each framebuffer byte inside the span,
+   so a span costs about one read-modify-write per 8 pixels.
+   operation: 'S' - set, 'C' - clear, 'I' - invert. */
+static void changeSpan_ST7920(unsigned short x, byte y, unsigned short length, char operation) {
+  if (x >= WIDTH_ST7920 || y >= 64) return;
+  unsigned short end = min(length, WIDTH_ST7920 - x) + x;
+  byte *row = framebuffer_ST7920[y];
+
+  for (unsigned short start = x; start < end;) {
+    byte index = start / 8;
+    byte first = start % 8;
+    byte count = min(end - start, 8 - first);
+    byte mask = (byte)(0b11111111 >> first) & ~(byte)(0b11111111 >> (first + count));
+    byte updated = operation == 'S' ? row[index] | mask : operation == 'C' ? row[index] & ~mask : row[index] ^ mask;
+    if (updated != row[index]) {
+      dirtyWords_ST7920[y] |= (RowMask_ST7920)1 << (index / 2);
+      row[index] = updated;
+    }
+    start += count;
   }
 }
 
 
+void drawSpan_ST7920(unsigned short x, byte y, unsigned short length, bool color) {
+  changeSpan_ST7920(x, y, length, color ? 'S' : 'C');
+}
+
+
+void invertRectangle_ST7920(unsigned short x, byte y, unsigned short width, byte height) {
+  for (byte row = y; row < y + height && row < 64; row++) changeSpan_ST7920(x, row, width, 'I');
+}
+
+
+void fillRectangle_ST7920(unsigned short x, byte y, unsigned short width, byte height, bool color) {
+  for (byte row = y; row < y + height && row < 64; row++) drawSpan_ST7920(x, row, width, color);
+}
+
+
+static void drawByte_ST7920(unsigned short x, byte y, byte value) {
+  byte *target = &framebuffer_ST7920[y][x / 8];
+  if (*target == value) return;
+  dirtyWords_ST7920[y] |= (RowMask_ST7920)1 << (x / 16);
+  *target = value;
+}
+
+
+void drawBitmap_ST7920(const byte bitmap[], unsigned short x, byte y, unsigned short width, byte height) {
+  byte bytesPerRow = (width + 7) / 8;
+  for (byte row = 0; row < height; row++) {
+    if (y + row >= 64) break;
+    if (x % 8 == 0 && width % 8 == 0) {
+      // Byte aligned, copy whole bytes instead of pixels.
+      for (byte i = 0; i < bytesPerRow && x + i * 8 < WIDTH_ST7920; i++)
+        drawByte_ST7920(x + i * 8, y + row, bitmap[row * bytesPerRow + i]);
+      continue;
+    }
+    for (unsigned short column = 0; column < width; column++) {
+      if (x + column >= WIDTH_ST7920) break;
+      bool color = bitmap[row * bytesPerRow + column / 8] & (0b10000000 >> (column % 8));
+      drawPixel_ST7920(x + column, y + row, color);
+    }
+  }
+}
+
+
+/* Send the changed words of a framebuffer row.
+   Each run of adjacent changed words costs one address set, the address counter
+   moves to the next word automatically after both bytes of a word are written. */
+static void flushRow_ST7920(byte row) {
+  RowMask_ST7920 dirty = dirtyWords_ST7920[row];
+  byte word = 0;
+
+  while (dirty) {
+    if (!(dirty & 1)) {
+      dirty >>= 1;
+      word += 1;
+      continue;
+    }
+    byte first = word;
+    while (dirty & 1) {
+      dirty >>= 1;
+      word += 1;
+    }
+    setGraphicCursor_ST7920(row, first);
+    sendData_ST7920(&framebuffer_ST7920[row][first * 2], (word - first) * 2);
+  }
+  dirtyWords_ST7920[row] = 0;
+}
+
+
+// The framebuffer only knows what it flushed to one page, another page is written in full.
+static void checkFramebufferPage_ST7920() {
+  if (framebufferPage_ST7920 != drawPage_ST7920) {
+    memset(dirtyWords_ST7920, 0b11111111, sizeof(dirtyWords_ST7920));
+    framebufferPage_ST7920 = drawPage_ST7920;
+  }
+}
+
+
+void flushFramebuffer_ST7920() {
+  PROBE_PROFILER(FLUSH_FRAMEBUFFER_PROFILER);
+  checkFramebufferPage_ST7920();
+  bool sent = false;
+  for (byte row = 0; row < 64; row++) {
+    if (!dirtyWords_ST7920[row]) continue;
+    flushRow_ST7920(row);
+    sent = true;
+  }
+  if (sent) restoreBlinkCursor_ST7920();
+}
+
+
+bool flushFramebufferRows_ST7920(byte rows) {
+  PROBE_PROFILER(FLUSH_FRAMEBUFFER_PROFILER);
+  checkFramebufferPage_ST7920();
+  byte sent = 0;
+  for (byte row = 0; row < 64; row++) {
+    if (!dirtyWords_ST7920[row]) continue;
+    if (sent == rows) {
+      restoreBlinkCursor_ST7920();
+      return false;
+    }
+    flushRow_ST7920(row);
+    sent += 1;
+  }
+  if (sent) restoreBlinkCursor_ST7920();
+  return true;
+}
+
+
+/* A cell holding a full character (GB2312 code or CGRAM glyph 0x0000-0x0006) can't
+   have one half replaced, the other half would turn into garbage. */
+static bool isFullCell_ST7920(byte cell) {
+  byte high = ddram_ST7920[drawPage_ST7920][cell * 2];
+  return high >= 0xA1 || high == 0x00;
+}
+
+
+/* Store a half character, keeping the other half of its cell from the local copy,
+   unless the cell held a full character which is replaced by a space. */
+static void storeHalfCharacter_ST7920(byte position, byte code) {
+  if (isFullCell_ST7920(position / 2)) storeCharacter_ST7920(position ^ 1, ' ');
+  storeCharacter_ST7920(position, code);
+}
+
+
+/* Store text of half characters and GB2312 full characters into the local DDRAM copy
+   and send the changed cells. A byte pair both in 0xA1-0xFE is a full character.
+   flash: true - chars is in program memory and read byte by byte, nothing is copied into RAM. */
+static void storeText_ST7920(const char chars[], bool flash, byte length, byte row, byte column) {
+  PROBE_PROFILER(PRINT_HALF_PROFILER);
+  byte position = row * COLUMNS_ST7920 + column; // range of position for half chars is 0 to 2 * POSITIONS_ST7920 - 1
+
+  for (byte i = 0; i < length && position < POSITIONS_ST7920 * 2; i++) {
+    byte code = flash ? pgm_read_byte(&chars[i]) : chars[i];
+    byte next = i + 1 >= length ? 0 : flash ? pgm_read_byte(&chars[i + 1]) : chars[i + 1];
+    if (code < 0xA1 || next < 0xA1) {
+      // A lead byte without its pair would be taken as half of a full character by the ROM.
+      storeHalfCharacter_ST7920(position++, code < 0xA1 ? code : '?');
+      continue;
+    }
+    // A full character takes a whole cell, in the right half of a cell it starts in the next one.
+    if (position % 2 == 1) storeHalfCharacter_ST7920(position++, ' ');
+    if (position >= POSITIONS_ST7920 * 2) break;
+    storeCharacter_ST7920(position++, code);
+    storeCharacter_ST7920(position++, next);
+    i += 1;
+  }
+
+  if (!frameOpen_ST7920) flushCells_ST7920();
+}
+
+
+static void storeFullCharacters_ST7920(const short chars[], bool flash, byte length, byte row, byte column) {
+  PROBE_PROFILER(PRINT_FULL_PROFILER);
+  byte position = row * (COLUMNS_ST7920 / 2) + column;
+
+  for (byte i = 0; i < length && position < POSITIONS_ST7920; i++, position++) {
+    short code = flash ? pgm_read_word(&chars[i]) : chars[i];
+    storeCharacter_ST7920(position * 2, code >> 8);
+    storeCharacter_ST7920(position * 2 + 1, code);
+  }
+
+  if (!frameOpen_ST7920) flushCells_ST7920();
+}
+
+
+void printHalfCharacters_ST7920(char chars[], byte length, byte row, byte column) {
+  storeText_ST7920(chars, false, length, row, column);
+}
+
+
+void printHalfCharactersFromFlash_ST7920(const char chars[], byte length, byte row, byte column) {
+  storeText_ST7920(chars, true, length, row, column);
+}
+
+
+void printHalfCharacters_ST7920(const __FlashStringHelper *chars, byte row, byte column) {
+  PGM_P text = (PGM_P)chars;
+  // Nothing past the display is printed, so the length is counted only that far and fits in a byte.
+  storeText_ST7920(text, true, strnlen_P(text, POSITIONS_ST7920 * 2), row, column);
+}
+
+
+void printText_ST7920(const char text[], byte row, byte column) {
+  storeText_ST7920(text, false, strnlen(text, POSITIONS_ST7920 * 2), row, column);
+}
+
+
+void printFullCharacters_ST7920(short chars[], byte length, byte row, byte column) {
+  storeFullCharacters_ST7920(chars, false, length, row, column);
+}
+
+
+void printFullCharactersFromFlash_ST7920(const short chars[], byte length, byte row, byte column) {
+  storeFullCharacters_ST7920(chars, true, length, row, column);
+}
+
+
 void test() {
   initialize_ST7920();
 
   delay(500);
-  short chineseChars[] = {
+  static const short chineseChars[] PROGMEM = {
     0xCEAA, 0xC1CB, 0xB6A9, 0xB5A5, 0xBCB8, 0xBAF5, 0xC5E3, 0xCBAF,
     0xB5E3, 0xCDB7, 0xB9FE, 0xD1FC, 0xBECD, 0xB2EE, 0xCFC2, 0xB9F2,
     0xC6A8, 0xB4F3, 0xB5E3, 0xCAC2, 0xB2BB, 0xB8D2, 0xB5C3, 0xD7EF,
     0xD2BB, 0xC4EA, 0xB5BD, 0xCDB7, 0xB2BB, 0xC0EB, 0xB8DA, 0xCEBB};
 
-  printFullCharacters_ST7920(chineseChars, 32, 0, 0);
+  printFullCharactersFromFlash_ST7920(chineseChars, 32, 0, 0);
   
   /*
   for (int i = 0; i < 1; i++) {
@@ -234,7 +1119,7 @@ void test() {
    6 bits (A5-A0) are used to express DDRAM address, so the range is 0-63 (0b000000 - 0b111111). 
    
    ST7920 is designed for 256*64 display.
-   However this driver is programmed for 128*64 display with ST7920.
+   This driver is programmed for 128*64 display by default, set WIDTH_ST7920 to 256 for 256*64 display.
    
    DDRAM address and corresponding cursor position for 256*64 display:
    Line 0: [00] [01] [02] [03] [04] [05] [06] [07] [08] [09] [10] [11] [12] [13] [14] [15]
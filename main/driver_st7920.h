@@ -12,12 +12,48 @@
    PSB - GND (select SPI as communication mode)
    RST - 3V3 (never reset) 
    BLA (backlight LED +) - 5V (some other module needs 3.3v)
-   BLK (backlight LED -) - GND */
+   BLK (backlight LED -) - GND
+   With SOFTWARE_SPI_ST7920, RS (CS), R/W (SID) and E (SCLK) go to
+   CS_PIN_ST7920, SID_PIN_ST7920 and SCLK_PIN_ST7920 instead. */
 
 
 #include <Arduino.h>
 
 
+/* Compile-time configuration of the display module.
+   Everything derived from these is folded by the compiler, nothing is checked at runtime. */
+#ifndef WIDTH_ST7920
+#define WIDTH_ST7920 128 // 128 or 256 pixels, height is always 64. Framebuffer of 256*64 takes 2 KB RAM.
+#endif
+#define SPI_CLOCK_ST7920 600000 // Hz, default limited by 800 ns minimum clock pulse width of ST7920, see setTiming_ST7920()
+
+/* true - instructions are queued and sent by SPI and Timer2 interrupts, drawing functions return immediately.
+   false - every instruction is sent and waited for in place.
+   Timer2 is occupied when it's true, so tone() and PWM on D3/D11 are unavailable.
+   It may be given on compiler command line, e.g. by the host emulator build. */
+#ifndef ASYNC_ST7920
+#define ASYNC_ST7920 true
+#endif
+
+/* false - hardware SPI on D10, D11 and D13 as wired above.
+   true - serial protocol generated by software on any pins, hardware SPI is left to other devices.
+   Software serial is blocking, so it only works with ASYNC_ST7920 false. */
+#define SOFTWARE_SPI_ST7920 false
+#define CS_PIN_ST7920 7
+#define SID_PIN_ST7920 8
+#define SCLK_PIN_ST7920 9
+
+/* true - every byte goes to transferByteExternal_ST7920() instead of SPI,
+   e.g. the emulator in host/ that runs the driver on a desktop. Only works with ASYNC_ST7920 false. */
+#ifndef EXTERNAL_TRANSPORT_ST7920
+#define EXTERNAL_TRANSPORT_ST7920 false
+#endif
+
+#define COLUMNS_ST7920 (WIDTH_ST7920 / 8) // half characters in a line, there are 4 lines
+#define POSITIONS_ST7920 (WIDTH_ST7920 / 4) // full characters on display
+#define PAGES_ST7920 (WIDTH_ST7920 == 128 ? 2 : 1) // 128*64 display shows half of DDRAM and GDRAM
+
+
 // 8*16 half height non-ascii character (icon) code
 #define SMILE_REVERSE 0x01
 #define SMILE 0x02
@@ -53,33 +89,169 @@
 #define TRIANGLE_UP_HOLLOW 0x7f
 
 
+#if EXTERNAL_TRANSPORT_ST7920
+// Provided by the transport, called for each byte in the order it would be clocked out.
+void transferByteExternal_ST7920(byte data);
+#endif
+
 void test();
 
-// Initialize the display according to the instructions in the datasheet.
-void initialize_ST7920(); 
+// true - queued instructions are still being sent to the display.
+bool isBusy_ST7920();
+
+/* micros() when the last queued instruction was executed, i.e. the last byte reached the panel.
+   Only meaningful while isBusy_ST7920() is false, without ASYNC_ST7920 it's simply now. */
+unsigned long getIdleMicros_ST7920();
+
+// Block until every queued instruction was sent and executed by the display.
+void waitUntilIdle_ST7920();
+
+/* Initialize the display according to the instructions in the datasheet.
+   The first call after an MCU reset that left the panel powered (watchdog, reset button)
+   only sends function set and display control again and keeps the local copies of DDRAM
+   and GDRAM, so the last frame stays on screen and only later changes are sent.
+   Return true for such a warm start, false when the display was cleared. */
+bool initialize_ST7920();
+
+/* Replace SPI_CLOCK_ST7920 by clock (Hz) and add slack (us) to the execution time of every instruction,
+   for modules that run faster or need more time than the datasheet says (see calibration.h).
+   It takes effect at the next initialize_ST7920(). Software SPI keeps its own clock. */
+void setTiming_ST7920(unsigned long clock, byte slack);
+
+// Clock actually in use (hardware SPI rounds down to F_CPU / 2^n) and slack, since the last initialization.
+unsigned long getClock_ST7920();
+byte getSlack_ST7920(); 
 
 // Clear all characters and home cursor (reset DDRAM data and address).
 void clearCharacterDisplay_ST7920(); 
 
+/* Turn on/off character display, underline cursor and blink cursor (not backlight).
+   status: true - ON, false - OFF. */
+void setDisplay_ST7920(bool status);
+void setUnderlineCursor_ST7920(bool status);
+void setBlinkCursor_ST7920(bool status);
+
 /* Turn on/off character and cursor display (not backlight)
    option: 'D' - display, 'C' - cursor, 'B' - cursor blink.
-   status: true - ON, false - OFF. */
-void setDisplayStatus_ST7920(char option, bool status);
+   status: true - ON, false - OFF.
+   It's inline so that a constant option chooses the function at compile time. */
+inline void setDisplayStatus_ST7920(char option, bool status) {
+  switch (option) {
+    case 'D':
+      setDisplay_ST7920(status);
+      break;
+    case 'C':
+      setUnderlineCursor_ST7920(status);
+      break;
+    case 'B':
+      setBlinkCursor_ST7920(status);
+      break;
+  }
+}
 
-/* Print a series of half height 8*16 characters.
+/* Print a series of half height 8*16 characters, mixed with 16*16 GB2312 characters
+   (two bytes both in 0xA1-0xFE), e.g. "\xCE\xC2\xB6\xC8 23.5C" for a temperature label.
    The order is from left to right and from top to bottom.
-   chars: An array of chars or half height character code for icons.
-   length: number of half characters in array.
+   Only the cells that differ from what is already on the display are sent.
+   A half character starting or ending in the middle of a cell keeps the other half of that
+   cell as it's on display, unless that was part of a full character, which becomes a space.
+   A full character always takes a whole cell, at an odd column it's moved right with a space.
+   chars: An array of chars, half height character code for icons or GB2312 byte pairs.
+   length: number of bytes in array.
    row (0-3): The row number (vertical position) of the first character.
-   column (0-15): The column number (horizontal position) of the first character. */
-void printHalfCharacters(char chars[], char length, char row, char column);
+   column (0 to COLUMNS_ST7920 - 1): The column number (horizontal position) of the first character. */
+void printHalfCharacters_ST7920(char chars[], byte length, byte row, byte column);
+
+/* Same as above, but chars is an array in program memory (PROGMEM),
+   or a string from F("...") whose length is counted by itself.
+   Characters are read from flash one by one, no RAM is taken for the text. */
+void printHalfCharactersFromFlash_ST7920(const char chars[], byte length, byte row, byte column);
+void printHalfCharacters_ST7920(const __FlashStringHelper *chars, byte row, byte column);
+
+// Same as above, for a zero terminated string in RAM. print_GB2312() of gb2312.h takes UTF-8 text.
+void printText_ST7920(const char text[], byte row, byte column);
 
 /* Print a series of 16*16 Chinese/Japanese/Korean characters.
    The order is from left to right and from top to bottom.
+   Only the cells that differ from what is already on the display are sent.
    chars: An array of GB codes of your characters.
    length: number of character codes in the array.
    row (0-3): The row number (vertical position) of the first character.
-   column (0-7): The column number (horizontal position) of the first character. */
+   column (0 to COLUMNS_ST7920 / 2 - 1): The column number (horizontal position) of the first character. */
 void printFullCharacters_ST7920(short chars[], byte length, byte row, byte column);
 
+// Same as above, but chars is an array of GB codes in program memory (PROGMEM).
+void printFullCharactersFromFlash_ST7920(const short chars[], byte length, byte row, byte column);
+
+/* Show a line of characters reversed or normally, nothing is sent if it's already so.
+   line (0-3): DDRAM line, on 128*64 display line 0 is display row 0 and 2, line 1 is row 1 and 3.
+   status: true - reversed, false - normal. */
+void setLineReverse_ST7920(byte line, bool status);
+
+/* Blink a full character cell (e.g. the digit being edited) with the blink cursor of ST7920,
+   which blinks by itself, so nothing is sent until the blink moves or stops.
+   The cursor is put back on the cell after each update that moves the address counter.
+   Use setLineReverse_ST7920() to highlight a whole line with one instruction,
+   and invertRectangle_ST7920() for a blinking region in graphic display.
+   row (0-3), column (0 to COLUMNS_ST7920 / 2 - 1): cell on the shown page. */
+void setBlinkCell_ST7920(byte row, byte column);
+void stopBlink_ST7920();
+
+/* Upload a 16*16 user glyph into CGRAM, there are 4 slots (0-3).
+   Glyph in slot n is printed by full character code GLYPH_ST7920(n).
+   Characters already showing the slot change with it immediately.
+   bitmap: 32 bytes, 16 rows of 2 bytes, MSB is the leftmost pixel. */
+#define GLYPH_ST7920(slot) ((short)((slot) * 2))
+void setGlyph_ST7920(byte slot, const byte bitmap[]);
+
+// true - a character on the display (as known by the local DDRAM copy) uses the glyph slot.
+bool isGlyphShown_ST7920(byte slot);
+
+/* Double buffering with vertical scroll, only on 128*64 display (2 pages).
+   Page 1 is the half of DDRAM and GDRAM which is not shown without scroll.
+   setDrawPage_ST7920 chooses where print functions and framebuffer flush write,
+   showPage_ST7920 shows a page with a single scroll address instruction.
+   flipPages_ST7920 shows the draw page and then draws into the page hidden by it.
+   The framebuffer only remembers one page, flushing it to the other page sends all of it. */
+void setDrawPage_ST7920(byte page);
+void showPage_ST7920(byte page);
+void flipPages_ST7920();
+
+/* Hold text updates from print functions until endFrame_ST7920().
+   Then text and graphics are sent grouped by instruction set to save switches. */
+void beginFrame_ST7920();
+void endFrame_ST7920();
+
+/* Turn on/off graphic display (GDRAM), which is shown on top of characters.
+   status: true - ON, false - OFF. */
+void setGraphicDisplay_ST7920(bool status);
+
+/* Clear the local framebuffer and mark every GDRAM word dirty,
+   so that the next flush brings GDRAM to a known blank state. */
+void clearFramebuffer_ST7920();
+
+/* Draw on the local framebuffer, nothing is sent to the display until flush.
+   x (0 to WIDTH_ST7920 - 1): horizontal position from left. y (0-63): vertical position from top.
+   x and widths are unsigned short, a full line of 256*64 display is 256 pixels wide.
+   color: true - pixel ON, false - pixel OFF. */
+void drawPixel_ST7920(unsigned short x, byte y, bool color);
+// length pixels from (x, y) to the right, clipped at the right edge.
+void drawSpan_ST7920(unsigned short x, byte y, unsigned short length, bool color);
+void fillRectangle_ST7920(unsigned short x, byte y, unsigned short width, byte height, bool color);
+
+/* Invert the pixels of a rectangle, doing it again restores them.
+   Toggling it and flushing costs only the GDRAM words it covers, e.g. 32 words for a clock digit. */
+void invertRectangle_ST7920(unsigned short x, byte y, unsigned short width, byte height);
+
+/* bitmap: 1 bit per pixel, MSB first, each row padded to whole bytes. */
+void drawBitmap_ST7920(const byte bitmap[], unsigned short x, byte y, unsigned short width, byte height);
+
+/* Send only the 16-bit GDRAM words that changed since the last flush. */
+void flushFramebuffer_ST7920();
+
+/* Same as above but stop after sending the changed words of the given number of rows,
+   so that a long flush can be spread over several calls.
+   Return true when nothing is left to send. */
+bool flushFramebufferRows_ST7920(byte rows);
+
 #endif
\ No newline at end of file
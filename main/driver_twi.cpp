@@ -0,0 +1,193 @@
+#include <Arduino.h>
+#include <util/twi.h>
+#include "driver_twi.h"
+
+
+#define QUEUE_SIZE_TWI 8 // power of 2 and no more than 128, so that byte indices wrap correctly
+
+static Transaction_TWI transactions_TWI[QUEUE_SIZE_TWI];
+volatile static byte queueHead_TWI = 0; // index of the transaction on the bus
+volatile static byte queueTail_TWI = 0; // index of the next free slot
+volatile static bool queueRunning_TWI = false; // true - interrupts are working on the queue
+static bool initialized_TWI = false;
+
+// Progress of the current transaction, only used in interrupt.
+static byte written_TWI = 0; // header and data bytes written
+static byte read_TWI = 0; // bytes read
+static unsigned short retries_TWI = 0; // retries left
+
+// Result of the transaction started by run_TWI().
+volatile static byte runResult_TWI;
+volatile static bool runDone_TWI;
+
+#define CONTROL_TWI (_BV(TWEN) | _BV(TWIE) | _BV(TWINT))
+
+
+void initialize_TWI() {
+  if (initialized_TWI) return;
+  initialized_TWI = true;
+  digitalWrite(SDA, HIGH); // internal pull-ups, the module has its own as well
+  digitalWrite(SCL, HIGH);
+  TWSR = 0; // prescaler 1
+  TWBR = (F_CPU / FREQUENCY_TWI - 16) / 2;
+  TWCR = _BV(TWEN);
+}
+
+
+static inline Transaction_TWI *current_TWI() {
+  return &transactions_TWI[queueHead_TWI % QUEUE_SIZE_TWI];
+}
+
+
+// Must be called with interrupts disabled.
+static void startNextTransaction_TWI() {
+  if (queueHead_TWI == queueTail_TWI) {
+    queueRunning_TWI = false;
+    return;
+  }
+  queueRunning_TWI = true;
+  written_TWI = 0;
+  read_TWI = 0;
+  retries_TWI = current_TWI()->retries;
+  TWCR = CONTROL_TWI | _BV(TWSTA);
+}
+
+
+/* Release the bus, report result and go on with the next transaction.
+   STOP and START may be requested at once, the hardware sends them in order. */
+static void finish_TWI(byte result) {
+  Callback_TWI callback = current_TWI()->callback;
+  if (callback) callback(result);
+  queueHead_TWI += 1;
+  if (queueHead_TWI == queueTail_TWI) {
+    TWCR = CONTROL_TWI | _BV(TWSTO);
+    queueRunning_TWI = false;
+  } else {
+    TWCR = CONTROL_TWI | _BV(TWSTO) | _BV(TWSTA);
+    written_TWI = 0;
+    read_TWI = 0;
+    retries_TWI = current_TWI()->retries;
+  }
+}
+
+
+// Address not acknowledged: try again from the start while retries are left.
+static void retry_TWI() {
+  if (retries_TWI == 0) {
+    finish_TWI(ADDRESS_NACK_TWI);
+    return;
+  }
+  retries_TWI -= 1;
+  written_TWI = 0;
+  read_TWI = 0;
+  TWCR = CONTROL_TWI | _BV(TWSTO) | _BV(TWSTA);
+}
+
+
+// Acknowledge received bytes except the last one, the NACK tells the device to stop.
+static inline void receiveNext_TWI(const Transaction_TWI *transaction) {
+  if (transaction->readLength - read_TWI > 1) TWCR = CONTROL_TWI | _BV(TWEA);
+  else TWCR = CONTROL_TWI;
+}
+
+
+ISR(TWI_vect) {
+  Transaction_TWI *transaction = current_TWI();
+  byte toWrite = transaction->headerLength + transaction->writeLength;
+
+  switch (TW_STATUS) {
+    case TW_START:
+      if (toWrite > 0 || transaction->readLength == 0) TWDR = transaction->address << 1 | TW_WRITE;
+      else TWDR = transaction->address << 1 | TW_READ;
+      TWCR = CONTROL_TWI;
+      break;
+
+    case TW_REP_START:
+      TWDR = transaction->address << 1 | TW_READ;
+      TWCR = CONTROL_TWI;
+      break;
+
+    case TW_MT_SLA_ACK:
+    case TW_MT_DATA_ACK:
+      if (written_TWI < toWrite) {
+        TWDR = written_TWI < transaction->headerLength ? transaction->header[written_TWI] :
+               transaction->writeData[written_TWI - transaction->headerLength];
+        written_TWI += 1;
+        TWCR = CONTROL_TWI;
+      } else if (transaction->readLength > 0) {
+        TWCR = CONTROL_TWI | _BV(TWSTA); // repeated start keeps the bus for reading
+      } else {
+        finish_TWI(DONE_TWI);
+      }
+      break;
+
+    case TW_MT_SLA_NACK:
+    case TW_MR_SLA_NACK:
+      retry_TWI();
+      break;
+
+    case TW_MT_DATA_NACK:
+      finish_TWI(DATA_NACK_TWI);
+      break;
+
+    case TW_MR_SLA_ACK:
+      receiveNext_TWI(transaction);
+      break;
+
+    case TW_MR_DATA_ACK:
+      transaction->readData[read_TWI++] = TWDR;
+      receiveNext_TWI(transaction);
+      break;
+
+    case TW_MR_DATA_NACK:
+      transaction->readData[read_TWI++] = TWDR;
+      finish_TWI(DONE_TWI);
+      break;
+
+    default: // TW_MT_ARB_LOST (same as TW_MR_ARB_LOST) or TW_BUS_ERROR
+      finish_TWI(BUS_ERROR_TWI);
+      break;
+  }
+}
+
+
+void queue_TWI(const Transaction_TWI *transaction) {
+  while ((byte)(queueTail_TWI - queueHead_TWI) >= QUEUE_SIZE_TWI); // wait for a free slot
+
+  transactions_TWI[queueTail_TWI % QUEUE_SIZE_TWI] = *transaction;
+
+  byte oldSREG = SREG;
+  cli();
+  queueTail_TWI += 1;
+  if (!queueRunning_TWI) {
+    while (TWCR & _BV(TWSTO)); // STOP of the last transaction may still be on the bus
+    startNextTransaction_TWI();
+  }
+  SREG = oldSREG;
+}
+
+
+static void finishRun_TWI(byte result) {
+  runResult_TWI = result;
+  runDone_TWI = true;
+}
+
+
+byte run_TWI(const Transaction_TWI *transaction) {
+  Transaction_TWI blocking = *transaction;
+  blocking.callback = finishRun_TWI;
+  runDone_TWI = false;
+  queue_TWI(&blocking);
+  while (!runDone_TWI);
+  return runResult_TWI;
+}
+
+
+bool isBusy_TWI() {
+  return queueRunning_TWI;
+}
+
+
+void waitUntilIdle_TWI() {
+  while (queueRunning_TWI);
+}
@@ -0,0 +1,56 @@
+#ifndef DRIVER_TWI_H
+#define DRIVER_TWI_H
+
+
+/* Interrupt driven I2C master shared by DS3231 and AT24C32 (SDA - A4, SCL - A5).
+   Transactions wait in a queue and are run one after another by the TWI interrupt,
+   so the CPU is free while bytes are on the bus.
+   A transaction writes its header and data, then reads after a repeated start,
+   either part may be empty. It replaces Wire, which uses the same interrupt. */
+
+
+#include <Arduino.h>
+
+
+#define FREQUENCY_TWI 400000 // Hz, both DS3231 and AT24C32 support fast mode
+
+// Results passed to completion callback.
+#define DONE_TWI 0
+#define ADDRESS_NACK_TWI 1 // no device answered (or EEPROM busy in write cycle)
+#define DATA_NACK_TWI 2 // device refused a written byte
+#define BUS_ERROR_TWI 3 // illegal START/STOP or lost arbitration
+
+/* Called in the interrupt when a transaction finishes, keep it short.
+   The read buffer is filled at that time. */
+typedef void (*Callback_TWI)(byte result);
+
+struct Transaction_TWI {
+  byte address; // 7-bit device address
+  byte header[2]; // written first, e.g. register pointer or EEPROM word address
+  byte headerLength;
+  const byte *writeData; // written after header, must stay valid until completion
+  byte writeLength;
+  byte *readData; // filled after repeated start, must stay valid until completion
+  byte readLength;
+  unsigned short retries; // times START is repeated when address isn't acknowledged
+  Callback_TWI callback; // NULL - no callback
+};
+
+
+// Enable TWI with internal pull-ups at FREQUENCY_TWI. Calling it again does nothing.
+void initialize_TWI();
+
+/* Copy transaction into queue and return immediately unless the queue is full.
+   Do not call it with interrupts disabled, otherwise a full queue never drains. */
+void queue_TWI(const Transaction_TWI *transaction);
+
+/* Queue transaction and wait until it finishes, return its result.
+   The callback of transaction is not called. */
+byte run_TWI(const Transaction_TWI *transaction);
+
+// Return true while a transaction is queued or on the bus.
+bool isBusy_TWI();
+
+void waitUntilIdle_TWI();
+
+#endif
@@ -0,0 +1,189 @@
+#include <Arduino.h>
+#include <SoftwareSerial.h>
+#include "driver_st7920.h"
+#include "driver_ds3231.h"
+#include "time_sync.h"
+#include "esp_link.h"
+
+
+static SoftwareSerial port_EspLink(RX_PIN_ESP_LINK, TX_PIN_ESP_LINK);
+
+// Receiving state: step 0 waits for SYNC_ESP_LINK, 1 for type, 2 for length, 3 for payload, 4 for check byte.
+static byte step_EspLink = 0;
+static byte type_EspLink;
+static byte length_EspLink;
+static byte received_EspLink; // payload bytes received
+static byte payload_EspLink[MAX_PAYLOAD_ESP_LINK];
+static unsigned long lastByte_EspLink = 0; // millis() of the last byte of a frame
+static unsigned long lastRequest_EspLink = 0; // millis() of the last time request
+static byte sequence_EspLink = 0; // of the last time request
+static unsigned long requestMicros_EspLink; // micros() when its check byte was sent
+static bool answered_EspLink = true; // true - the last time request has its answer
+static byte attempts_EspLink = 0; // time requests sent for the current sample
+static byte syncReport_EspLink[5]; // SYNC_REPORT_ESP_LINK payload waiting for a pause between received frames
+static bool syncReportPending_EspLink = false;
+
+static unsigned long frames_EspLink = 0; // frames applied
+static unsigned long rejected_EspLink = 0; // frames answered by NACK_ESP_LINK
+static unsigned long dropped_EspLink = 0; // bytes received outside a frame
+static unsigned long repeats_EspLink = 0; // time requests repeated for lack of answer
+
+
+static void send_EspLink(byte type, const byte payload[], byte length) {
+  byte sum = type + length;
+  port_EspLink.write(SYNC_ESP_LINK);
+  port_EspLink.write(type);
+  port_EspLink.write(length);
+  for (byte i = 0; i < length; i++) {
+    port_EspLink.write(payload[i]);
+    sum += payload[i];
+  }
+  port_EspLink.write((byte)~sum);
+}
+
+
+// repeat: true - the last request wasn't answered, false - a new sample.
+static void requestTime_EspLink(bool repeat) {
+  if (repeat) repeats_EspLink += 1;
+  attempts_EspLink = repeat ? attempts_EspLink + 1 : 1;
+  sequence_EspLink += 1;
+  send_EspLink(TIME_REQUEST_ESP_LINK, &sequence_EspLink, 1);
+  // SoftwareSerial returns after the stop bit, so this is when the ESP-12F receives the byte.
+  requestMicros_EspLink = micros();
+  answered_EspLink = false;
+  lastRequest_EspLink = millis();
+}
+
+
+void initialize_EspLink() {
+  port_EspLink.begin(BAUD_ESP_LINK);
+  requestTime_EspLink(false);
+}
+
+
+static unsigned long readLong_EspLink(const byte bytes[]) {
+  return (unsigned long)bytes[0] | (unsigned long)bytes[1] << 8 | (unsigned long)bytes[2] << 16 |
+         (unsigned long)bytes[3] << 24;
+}
+
+
+// Apply a complete frame, return false when it's not valid.
+static bool apply_EspLink() {
+  byte *payload = payload_EspLink;
+  byte length = length_EspLink;
+
+  switch (type_EspLink) {
+    case TIME_ESP_LINK:
+      if (length != 1 + sizeof(Time_DS3231) + 4 || payload[0] != sequence_EspLink || answered_EspLink) return false;
+      answered_EspLink = true;
+      return submit_TimeSync((const Time_DS3231 *)(payload + 1), readLong_EspLink(payload + 1 + sizeof(Time_DS3231)),
+                             requestMicros_EspLink);
+    case TEXT_ESP_LINK:
+      if (length < 2 || payload[0] >= POSITIONS_ST7920 * 2) return false;
+      printHalfCharacters_ST7920((char *)payload + 1, length - 1,
+                                 payload[0] / COLUMNS_ST7920, payload[0] % COLUMNS_ST7920);
+      return true;
+    case PIXELS_ESP_LINK:
+      if (length < 3 || payload[0] % 8 != 0 || payload[1] >= 64 || payload[0] + (length - 2) * 8 > WIDTH_ST7920)
+        return false;
+      drawBitmap_ST7920(payload + 2, payload[0], payload[1], (length - 2) * 8, 1);
+      return true;
+    case FRAME_ESP_LINK:
+      if (length != 1) return false;
+      if (payload[0]) beginFrame_ST7920();
+      else endFrame_ST7920();
+      return true;
+  }
+  return false;
+}
+
+
+static void receive_EspLink(byte data) {
+  switch (step_EspLink) {
+    case 0:
+      if (data == SYNC_ESP_LINK) step_EspLink = 1;
+      else dropped_EspLink += 1;
+      return;
+    case 1:
+      type_EspLink = data;
+      step_EspLink = 2;
+      return;
+    case 2:
+      if (data > MAX_PAYLOAD_ESP_LINK) {
+        // Can't be stored, and its end can't be trusted either, so search for the next start.
+        byte reason = BAD_FRAME_ESP_LINK;
+        step_EspLink = 0;
+        rejected_EspLink += 1;
+        send_EspLink(NACK_ESP_LINK, &reason, 1);
+        return;
+      }
+      length_EspLink = data;
+      received_EspLink = 0;
+      step_EspLink = data > 0 ? 3 : 4;
+      return;
+    case 3:
+      payload_EspLink[received_EspLink++] = data;
+      if (received_EspLink == length_EspLink) step_EspLink = 4;
+      return;
+  }
+
+  // Check byte.
+  step_EspLink = 0;
+  byte sum = type_EspLink + length_EspLink;
+  for (byte i = 0; i < length_EspLink; i++) sum += payload_EspLink[i];
+
+  byte reason = CHECK_ERROR_ESP_LINK;
+  if ((byte)~sum == data) {
+    if (apply_EspLink()) {
+      frames_EspLink += 1;
+      send_EspLink(ACK_ESP_LINK, &type_EspLink, 1);
+      return;
+    }
+    reason = BAD_FRAME_ESP_LINK;
+  }
+  rejected_EspLink += 1;
+  send_EspLink(NACK_ESP_LINK, &reason, 1);
+}
+
+
+void poll_EspLink() {
+  if (step_EspLink != 0 && millis() - lastByte_EspLink > BYTE_TIMEOUT_ESP_LINK) step_EspLink = 0;
+  while (port_EspLink.available() > 0) {
+    receive_EspLink(port_EspLink.read());
+    lastByte_EspLink = millis();
+  }
+
+  long error;
+  if (poll_TimeSync(&error)) {
+    syncReport_EspLink[0] = error;
+    syncReport_EspLink[1] = error >> 8;
+    syncReport_EspLink[2] = error >> 16;
+    syncReport_EspLink[3] = error >> 24;
+    syncReport_EspLink[4] = readAgingOffset_DS3231();
+    syncReportPending_EspLink = true;
+  }
+
+  // Sending in the middle of a received frame would break it.
+  if (step_EspLink != 0) return;
+  if (syncReportPending_EspLink) {
+    syncReportPending_EspLink = false;
+    send_EspLink(SYNC_REPORT_ESP_LINK, syncReport_EspLink, sizeof(syncReport_EspLink));
+  }
+  unsigned long elapsed = millis() - lastRequest_EspLink;
+  if (elapsed > REQUEST_INTERVAL_ESP_LINK) requestTime_EspLink(false);
+  else if (!answered_EspLink && attempts_EspLink < REQUEST_ATTEMPTS_ESP_LINK && elapsed > REPLY_TIMEOUT_ESP_LINK)
+    requestTime_EspLink(true);
+}
+
+
+void report_EspLink(Print &output) {
+  output.print(F("link frames: "));
+  output.print(frames_EspLink);
+  output.print(F(", rejected: "));
+  output.print(rejected_EspLink);
+  output.print(F(", bytes dropped: "));
+  output.print(dropped_EspLink);
+  output.print(F(", time requests repeated: "));
+  output.println(repeats_EspLink);
+  report_TimeSync(output);
+}
@@ -0,0 +1,87 @@
+#ifndef ESP_LINK_H
+#define ESP_LINK_H
+
+
+/* Wire Connection for Arduino Nano:
+   ESP-12F - Nano Board
+   VCC - 3.3V regulator of its own (the ESP-12F draws up to 300 mA when transmitting)
+   GND - GND
+   TXD0 - RX_PIN_ESP_LINK
+   RXD0 - TX_PIN_ESP_LINK through a 1K/2K divider, the ESP-12F is not 5V tolerant
+   EN, RST, GPIO0 - 3.3V through 10K; GPIO15 - GND through 10K (boot from flash)
+
+   The link has a software serial port of its own, Serial stays with the console and the USB chip.
+   SoftwareSerial keeps interrupts off for about one byte time (0.5 ms at 19200 baud) per byte,
+   the other interrupt drivers only get a little slower then. Bytes outside a frame are dropped.
+   It's half duplex: whatever arrives while the Nano is sending is broken, so the link is stop-and-wait:
+   - The ESP-12F sends one frame, then nothing until the Nano answered it with ACK_ESP_LINK or NACK_ESP_LINK.
+     Without answer in ANSWER_TIMEOUT_ESP_LINK it sends the frame again, also after NACK with
+     CHECK_ERROR_ESP_LINK. Frames are idempotent, so a repeat of a frame whose ACK was lost does no harm.
+   - The ESP-12F doesn't start a frame while one from the Nano is arriving.
+   - The Nano sends its own frames only between received frames and repeats an unanswered
+     TIME_REQUEST_ESP_LINK after REPLY_TIMEOUT_ESP_LINK.
+
+   The ESP-12F does NTP and any parsing, the Nano only copies fixed layouts:
+   SYNC_ESP_LINK, type, length (0 to MAX_PAYLOAD_ESP_LINK), payload, ~(sum of type, length and payload).
+   Multi-byte numbers are little endian.
+
+   From the Nano:
+   TIME_REQUEST_ESP_LINK  sequence (1 byte), sent at start and every REQUEST_INTERVAL_ESP_LINK.
+                          The Nano takes micros() right after writing the check byte.
+                          A repeat has a new sequence, the answer to an old one is rejected.
+   SYNC_REPORT_ESP_LINK   error (RTC minus network time, us, int32) and aging offset (int8),
+                          after each applied time sample (see time_sync.h).
+   ACK_ESP_LINK           type of an applied frame.
+   NACK_ESP_LINK          reason a frame was rejected.
+
+   From the ESP-12F:
+   TIME_ESP_LINK    sequence of the request, Time_DS3231 (7 BCD bytes, 24-hour) and microseconds
+                    (uint32, 0-999999): network time when the check byte of the request was received.
+                    The ESP-12F has to timestamp that byte by its UART interrupt (RX FIFO threshold 1).
+   TEXT_ESP_LINK    half character position (row * COLUMNS_ST7920 + column), then character codes
+                    (ASCII, GB2312 byte pairs) as printHalfCharacters_ST7920() takes them.
+   PIXELS_ESP_LINK  x (multiple of 8), y, then bytes of one row of pixels, MSB is the leftmost.
+   FRAME_ESP_LINK   1 - begin a frame, 0 - end it (see beginFrame_ST7920()). */
+
+
+#include <Arduino.h>
+
+
+#define RX_PIN_ESP_LINK 4
+#define TX_PIN_ESP_LINK 5
+#define BAUD_ESP_LINK 19200 // a bit lasts 52 us, so other interrupts delaying the receiver don't break bytes
+#define SYNC_ESP_LINK 0xA5
+#define MAX_PAYLOAD_ESP_LINK 40 // a pixel row of a 256 pixels wide display and its position
+#define BYTE_TIMEOUT_ESP_LINK 100 // ms between bytes of a frame before it's dropped
+#define REQUEST_INTERVAL_ESP_LINK 600000UL // ms between time samples
+#define REPLY_TIMEOUT_ESP_LINK 2000 // ms the Nano waits for TIME_ESP_LINK before asking again
+#define REQUEST_ATTEMPTS_ESP_LINK 3 // time requests of one sample before waiting for the next interval
+#define ANSWER_TIMEOUT_ESP_LINK 200 // ms the ESP-12F waits for ACK or NACK of a frame before repeating it
+
+// Frame types from the ESP-12F.
+#define TIME_ESP_LINK 0x01
+#define TEXT_ESP_LINK 0x02
+#define PIXELS_ESP_LINK 0x03
+#define FRAME_ESP_LINK 0x04
+
+// Frame types from the Nano.
+#define ACK_ESP_LINK 0x80
+#define NACK_ESP_LINK 0x81
+#define TIME_REQUEST_ESP_LINK 0x82
+#define SYNC_REPORT_ESP_LINK 0x83
+
+// Reasons of NACK_ESP_LINK.
+#define CHECK_ERROR_ESP_LINK 1 // check byte doesn't match
+#define BAD_FRAME_ESP_LINK 2 // unknown type, wrong length, content out of range or answer to an old request
+
+
+// Start the software serial port and ask for the time.
+void initialize_EspLink();
+
+// Handle the bytes received so far and return, frames are applied as soon as they're complete.
+void poll_EspLink();
+
+// Print frame counters of the link and the state of time sync.
+void report_EspLink(Print &output);
+
+#endif
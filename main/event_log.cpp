@@ -0,0 +1,111 @@
+#include <Arduino.h>
+#include "driver_at24c32.h"
+#include "driver_ds3231.h"
+#include "event_log.h"
+
+
+static_assert(sizeof(Record_EventLog) == RECORD_SIZE_EVENT_LOG, "record must fill its slot exactly");
+
+static unsigned short head_EventLog = 0; // index of the slot for the next record
+static unsigned short records_EventLog = 0; // number of valid records
+static unsigned short sequence_EventLog = 0; // sequence number of the next record
+
+
+static byte checksum_EventLog(const Record_EventLog *record) {
+  const byte *bytes = (const byte *)record;
+  byte sum = 0;
+  for (byte i = 0; i < sizeof(Record_EventLog) - 1; i++) sum += bytes[i];
+  return ~sum;
+}
+
+
+static unsigned short address_EventLog(unsigned short index) {
+  return START_EVENT_LOG + index * RECORD_SIZE_EVENT_LOG;
+}
+
+
+static bool readRecord_EventLog(unsigned short index, Record_EventLog *record) {
+  if (!readBytes_AT24C32(address_EventLog(index), (byte *)record, sizeof(Record_EventLog))) return false;
+  return record->checksum == checksum_EventLog(record);
+}
+
+
+void initialize_EventLog() {
+  Record_EventLog first, record;
+  head_EventLog = 0;
+  records_EventLog = 0;
+  sequence_EventLog = 0;
+
+  /* The search is anchored on the first valid slot. Slot 0 is broken when power went
+     while it was written after a wrap, the newest records are then at the end of the log. */
+  unsigned short anchor = 0;
+  while (!readRecord_EventLog(anchor, &first))
+    if (++anchor == RECORDS_EVENT_LOG) return; // empty log
+
+  /* Slot i holds sequence first + i - anchor up to the newest record,
+     and older, broken (a torn write of the head) or no records after it.
+     Find the last slot keeping this relation. */
+  unsigned short low = anchor, high = RECORDS_EVENT_LOG - 1;
+  while (low < high) {
+    unsigned short middle = (low + high + 1) / 2;
+    if (readRecord_EventLog(middle, &record) &&
+        (unsigned short)(record.sequence - first.sequence) == middle - anchor)
+      low = middle;
+    else
+      high = middle - 1;
+  }
+
+  head_EventLog = (low + 1) % RECORDS_EVENT_LOG;
+  sequence_EventLog = first.sequence + (low - anchor) + 1;
+
+  // The log has wrapped if a slot after the newest one holds a valid record, the first of them may be torn.
+  records_EventLog = low + 1;
+  for (unsigned short index = low + 1; index < RECORDS_EVENT_LOG && index <= low + 2; index++)
+    if (readRecord_EventLog(index, &record)) records_EventLog = RECORDS_EVENT_LOG;
+}
+
+
+unsigned short count_EventLog() {
+  return records_EventLog;
+}
+
+
+bool append_EventLog(byte event, unsigned long data) {
+  Time_DS3231 time;
+  Record_EventLog record;
+  getTime_DS3231(&time);
+
+  record.sequence = sequence_EventLog;
+  record.seconds = time.seconds;
+  record.minutes = time.minutes;
+  record.hours = time.hours;
+  record.date = time.date;
+  record.month = time.month;
+  record.year = time.year;
+  record.event = event;
+  record.temperature = readTemperature_DS3231();
+  record.data = data;
+  record.checksum = checksum_EventLog(&record);
+
+  if (!writeBytes_AT24C32(address_EventLog(head_EventLog), (const byte *)&record, sizeof(Record_EventLog)))
+    return false;
+
+  sequence_EventLog += 1;
+  head_EventLog = (head_EventLog + 1) % RECORDS_EVENT_LOG;
+  if (records_EventLog < RECORDS_EVENT_LOG) records_EventLog += 1;
+  // A filled page goes to the chip right away, one write cycle for all records in it.
+  if (address_EventLog(head_EventLog) % PAGE_SIZE_AT24C32 == 0) return flush_AT24C32();
+  return true;
+}
+
+
+bool flush_EventLog() {
+  return flush_AT24C32();
+}
+
+
+bool read_EventLog(unsigned short age, Record_EventLog *record) {
+  if (age >= records_EventLog) return false;
+  unsigned short index = (head_EventLog + RECORDS_EVENT_LOG - 1 - age) % RECORDS_EVENT_LOG;
+  return readRecord_EventLog(index, record);
+}
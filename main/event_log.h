@@ -0,0 +1,61 @@
+#ifndef EVENT_LOG_H
+#define EVENT_LOG_H
+
+
+/* Circular log of fixed size records on the AT24C32.
+   Records are written one after another through the whole log area and wrap around,
+   so that every page is worn equally. Each record carries a sequence number,
+   which lets initialization find the newest record by binary search
+   instead of reading the whole log area. */
+
+
+#include <Arduino.h>
+
+
+#define START_EVENT_LOG 0x0000 // first address of log area, page aligned
+#define END_EVENT_LOG 0x0C00 // address after log area, page aligned (3 KB, 192 records)
+#define RECORD_SIZE_EVENT_LOG 16 // divides page size, so a record never crosses pages
+#define RECORDS_EVENT_LOG ((END_EVENT_LOG - START_EVENT_LOG) / RECORD_SIZE_EVENT_LOG)
+
+// Event codes.
+#define BOOT_EVENT_LOG 0x01
+#define TEMPERATURE_EVENT_LOG 0x02
+#define TIME_SET_EVENT_LOG 0x03
+
+
+struct __attribute__((packed)) Record_EventLog {
+  unsigned short sequence; // increases by 1 for each record
+  byte seconds; // BCD timestamp from DS3231
+  byte minutes;
+  byte hours;
+  byte date;
+  byte month;
+  byte year;
+  byte event; // event code
+  short temperature; // 0.25 degree Celsius steps
+  uint32_t data; // depends on event
+  byte checksum; // makes erased or partly written records invalid
+};
+
+
+/* Locate the newest record with binary search over sequence numbers.
+   AT24C32 and DS3231 must be initialized already. */
+void initialize_EventLog();
+
+// Number of valid records, up to RECORDS_EVENT_LOG.
+unsigned short count_EventLog();
+
+/* Append a record with current time and temperature.
+   It stays in the EEPROM write-combining buffer until the record filling its page is appended,
+   so that two records in the same page cost one write cycle.
+   A record still in the buffer is lost with power, flush_EventLog() writes it earlier. */
+bool append_EventLog(byte event, unsigned long data);
+
+// Write buffered records into the EEPROM now, e.g. before power goes. It costs a write cycle of its page.
+bool flush_EventLog();
+
+/* Read a record, age 0 is the newest one.
+   Return false if there are not so many records or the record is broken. */
+bool read_EventLog(unsigned short age, Record_EventLog *record);
+
+#endif
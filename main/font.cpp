@@ -0,0 +1,39 @@
+#include <Arduino.h>
+#include "driver_st7920.h"
+#include "font.h"
+
+
+// Draw one run-list row at (x, y), return the address after it.
+static const byte *drawRow_Font(const byte *row, byte width, byte x, byte y) {
+  byte runs = pgm_read_byte(row++);
+  byte drawn = 0;
+  bool color = false;
+  for (byte i = 0; i < runs; i++, color = !color) {
+    byte length = pgm_read_byte(row++);
+    drawSpan_ST7920(x + drawn, y, length, color);
+    drawn += length;
+  }
+  if (drawn < width) drawSpan_ST7920(x + drawn, y, width - drawn, false);
+  return row;
+}
+
+
+void drawGlyph_Font(const Font_Font *font, byte glyph, byte x, byte y) {
+  if (glyph >= font->glyphs) return;
+  const byte *data = font->data + pgm_read_word(&font->offsets[glyph]);
+  const byte *previous = data;
+
+  for (byte row = 0; row < font->height;) {
+    byte code = pgm_read_byte(data);
+    if (code & 0b10000000) {
+      // Decoding the previous row again costs less than keeping a copy of it.
+      for (byte i = code & 0b01111111; i > 0 && row < font->height; i--, row++)
+        drawRow_Font(previous, font->width, x, y + row);
+      data += 1;
+    } else {
+      previous = data;
+      data = drawRow_Font(data, font->width, x, y + row);
+      row += 1;
+    }
+  }
+}
@@ -0,0 +1,30 @@
+#ifndef FONT_H
+#define FONT_H
+
+
+/* Compressed 1-bpp fonts and icons in program memory, made by tools/make_font.py.
+   Each pixel row of a glyph is either a repeat of the previous row or a list of runs:
+   0b1nnnnnnn - the previous row again, n times.
+   0b0nnnnnnn followed by n run lengths - alternately clear and set pixels, starting with clear,
+   pixels after the last run are clear.
+   Runs are drawn into the framebuffer of driver_st7920 a byte at a time, clear runs included,
+   so every pixel is written once in its final color and only real changes become dirty words. */
+
+
+#include <Arduino.h>
+
+
+struct Font_Font {
+  byte width; // pixels of every glyph
+  byte height;
+  byte glyphs; // number of glyphs
+  const unsigned short *offsets; // PROGMEM, start of each glyph in data
+  const byte *data; // PROGMEM, rows of all glyphs
+};
+
+
+/* Draw glyph of font with its top left corner at (x, y), into the framebuffer only.
+   Nothing is sent, call flushFramebuffer_ST7920() afterwards. */
+void drawGlyph_Font(const Font_Font *font, byte glyph, byte x, byte y);
+
+#endif
@@ -0,0 +1,30 @@
+#ifndef FONT_CLOCK_DIGITS_H
+#define FONT_CLOCK_DIGITS_H
+
+
+/* Generated by tools/make_font.py from tools/fonts/clock_digits.txt, do not edit.
+   10 glyphs of 16*32, 188 bytes compressed, 640 bytes raw. */
+
+
+#include "font.h"
+
+
+static const unsigned short clockDigitsOffsets_Font[10] PROGMEM = {
+  0, 14, 18, 38, 58, 72, 92, 114, 122, 146};
+
+static const byte clockDigitsData_Font[168] PROGMEM = {
+  0x02, 0x02, 0x0C, 0x82, 0x04, 0x02, 0x03, 0x06, 0x03, 0x99, 0x02, 0x02, 0x0C, 0x82, // 0
+  0x02, 0x0B, 0x03, 0x9F, // 1
+  0x02, 0x02, 0x0C, 0x82, 0x02, 0x0B, 0x03, 0x8A, 0x02, 0x02, 0x0C, 0x82, 0x02, 0x02, 0x03, 0x8B, 0x02, 0x02, 0x0C, 0x82, // 2
+  0x02, 0x02, 0x0C, 0x82, 0x02, 0x0B, 0x03, 0x8A, 0x02, 0x02, 0x0C, 0x82, 0x02, 0x0B, 0x03, 0x8B, 0x02, 0x02, 0x0C, 0x82, // 3
+  0x04, 0x02, 0x03, 0x06, 0x03, 0x8D, 0x02, 0x02, 0x0C, 0x82, 0x02, 0x0B, 0x03, 0x8E, // 4
+  0x02, 0x02, 0x0C, 0x82, 0x02, 0x02, 0x03, 0x8A, 0x02, 0x02, 0x0C, 0x82, 0x02, 0x0B, 0x03, 0x8B, 0x02, 0x02, 0x0C, 0x82, // 5
+  0x02, 0x02, 0x0C, 0x82, 0x02, 0x02, 0x03, 0x8A, 0x02, 0x02, 0x0C, 0x82, 0x04, 0x02, 0x03, 0x06, 0x03, 0x8B, 0x02, 0x02, 0x0C, 0x82, // 6
+  0x02, 0x02, 0x0C, 0x82, 0x02, 0x0B, 0x03, 0x9C, // 7
+  0x02, 0x02, 0x0C, 0x82, 0x04, 0x02, 0x03, 0x06, 0x03, 0x8A, 0x02, 0x02, 0x0C, 0x82, 0x04, 0x02, 0x03, 0x06, 0x03, 0x8B, 0x02, 0x02, 0x0C, 0x82, // 8
+  0x02, 0x02, 0x0C, 0x82, 0x04, 0x02, 0x03, 0x06, 0x03, 0x8A, 0x02, 0x02, 0x0C, 0x82, 0x02, 0x0B, 0x03, 0x8B, 0x02, 0x02, 0x0C, 0x82, // 9
+};
+
+static const Font_Font clockDigits_Font = {16, 32, 10, clockDigitsOffsets_Font, clockDigitsData_Font};
+
+#endif
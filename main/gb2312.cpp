@@ -0,0 +1,87 @@
+#include <Arduino.h>
+#include "driver_st7920.h"
+#include "gb2312.h"
+#include "gb2312_table.h"
+
+
+unsigned short lookup_GB2312(unsigned short unicode) {
+  unsigned short low = 0;
+  unsigned short high = ENTRIES_GB2312;
+  while (low < high) {
+    unsigned short middle = (low + high) / 2;
+    unsigned short entry = pgm_read_word(&unicodes_GB2312[middle]);
+    if (entry == unicode) return pgm_read_word(&codes_GB2312[middle]);
+    if (entry < unicode) low = middle + 1;
+    else high = middle;
+  }
+  return 0;
+}
+
+
+static inline byte readByte_GB2312(const char *text, bool flash) {
+  return flash ? pgm_read_byte(text) : *text;
+}
+
+
+/* Decode the UTF-8 sequence at text into a code point and move text past it.
+   Malformed sequences and characters beyond U+FFFF decode as 0xFFFF, which is never in the table. */
+static unsigned short decode_GB2312(const char **text, bool flash) {
+  byte lead = readByte_GB2312((*text)++, flash);
+  if (lead < 0x80) return lead;
+
+  byte following;
+  unsigned long unicode;
+  if ((lead & 0b11100000) == 0b11000000) {
+    following = 1;
+    unicode = lead & 0b00011111;
+  } else if ((lead & 0b11110000) == 0b11100000) {
+    following = 2;
+    unicode = lead & 0b00001111;
+  } else if ((lead & 0b11111000) == 0b11110000) {
+    following = 3;
+    unicode = lead & 0b00000111;
+  } else {
+    return 0xFFFF; // stray continuation byte
+  }
+
+  for (; following > 0; following--) {
+    byte next = readByte_GB2312(*text, flash);
+    if ((next & 0b11000000) != 0b10000000) return 0xFFFF; // cut short, the next byte starts again
+    unicode = unicode << 6 | (next & 0b00111111);
+    *text += 1;
+  }
+  return unicode > 0xFFFF ? 0xFFFF : unicode;
+}
+
+
+byte convert_GB2312(const char text[], bool flash, char output[], byte size) {
+  byte length = 0;
+  while (readByte_GB2312(text, flash) != 0) {
+    unsigned short unicode = decode_GB2312(&text, flash);
+    unsigned short code = unicode < 0x80 ? 0 : lookup_GB2312(unicode);
+    if (code == 0) {
+      if (length + 1 >= size) break;
+      output[length++] = unicode < 0x80 ? unicode : MISSING_GB2312;
+    } else {
+      if (length + 2 >= size) break;
+      output[length++] = code >> 8;
+      output[length++] = code & 0xFF;
+    }
+  }
+  if (size > 0) output[length] = 0;
+  return length;
+}
+
+
+void print_GB2312(const char text[], byte row, byte column) {
+  char converted[POSITIONS_ST7920 * 2 + 1]; // the whole display in half characters
+  convert_GB2312(text, false, converted, sizeof(converted));
+  printText_ST7920(converted, row, column);
+}
+
+
+void print_GB2312(const __FlashStringHelper *text, byte row, byte column) {
+  char converted[POSITIONS_ST7920 * 2 + 1];
+  convert_GB2312((const char *)text, true, converted, sizeof(converted));
+  printText_ST7920(converted, row, column);
+}
@@ -0,0 +1,31 @@
+#ifndef GB2312_H
+#define GB2312_H
+
+
+/* UTF-8 text on the character display of driver_st7920.
+   ASCII is shown by the half width ROM font as it is. Other characters are looked up in
+   gb2312_table.h, which tools/make_gb2312.py builds for the characters listed in
+   tools/gb2312/charset.txt, so only the characters in use take flash (4 bytes each).
+   The table is sorted by code point and searched in place, no RAM is taken for it.
+   A character missing from the table is shown as MISSING_GB2312. */
+
+
+#include <Arduino.h>
+
+#define MISSING_GB2312 '?'
+
+// GB2312 code of a Unicode character, or 0 when it's not in the table.
+unsigned short lookup_GB2312(unsigned short unicode);
+
+/* Convert zero terminated UTF-8 text into the GB2312 bytes printText_ST7920() takes.
+   flash: true - text is in program memory.
+   At most size - 1 bytes and a terminator are written, a full character is never cut in half.
+   Return the number of bytes written, terminator excluded. */
+byte convert_GB2312(const char text[], bool flash, char output[], byte size);
+
+/* Convert text and print it from position (row, column) in half characters,
+   through the batched DDRAM writer of printText_ST7920(). Text after the last position is dropped. */
+void print_GB2312(const char text[], byte row, byte column);
+void print_GB2312(const __FlashStringHelper *text, byte row, byte column);
+
+#endif
@@ -0,0 +1,36 @@
+#ifndef GB2312_TABLE_H
+#define GB2312_TABLE_H
+
+
+/* Generated by tools/make_gb2312.py from tools/gb2312/charset.txt, do not edit.
+   64 characters, 256 bytes. */
+
+
+#include <Arduino.h>
+
+#define ENTRIES_GB2312 64
+
+// Sorted, so that unicodes_GB2312[i] is shown by codes_GB2312[i].
+static const unsigned short unicodes_GB2312[ENTRIES_GB2312] PROGMEM = {
+  0x2103, 0x4E00, 0x4E09, 0x4E0A, 0x4E0B, 0x4E0D, 0x4E3A, 0x4E4E, // ℃一三上下不为乎
+  0x4E86, 0x4E8B, 0x4E8C, 0x4E94, 0x4EAE, 0x4F4D, 0x4FDD, 0x516D, // 了事二五亮位保六
+  0x5173, 0x51C6, 0x51E0, 0x5206, 0x5230, 0x5348, 0x5355, 0x53D6, // 关准几分到午单取
+  0x54C8, 0x56DB, 0x56DE, 0x5927, 0x5934, 0x5B58, 0x5B9A, 0x5C31, // 哈四回大头存定就
+  0x5C41, 0x5C97, 0x5DEE, 0x5E74, 0x5EA6, 0x5F00, 0x5F97, 0x6562, // 屁岗差年度开得敢
+  0x65E5, 0x65F6, 0x661F, 0x6708, 0x671F, 0x6821, 0x6D88, 0x6E29, // 日时星月期校消温
+  0x70B9, 0x7761, 0x786E, 0x79BB, 0x79D2, 0x7F6A, 0x7F6E, 0x8170, // 点睡确离秒罪置腰
+  0x8BA2, 0x8BBE, 0x8DEA, 0x8FD4, 0x949F, 0x95F4, 0x95F9, 0x966A, // 订设跪返钟间闹陪
+};
+
+static const unsigned short codes_GB2312[ENTRIES_GB2312] PROGMEM = {
+  0xA1E6, 0xD2BB, 0xC8FD, 0xC9CF, 0xCFC2, 0xB2BB, 0xCEAA, 0xBAF5,
+  0xC1CB, 0xCAC2, 0xB6FE, 0xCEE5, 0xC1C1, 0xCEBB, 0xB1A3, 0xC1F9,
+  0xB9D8, 0xD7BC, 0xBCB8, 0xB7D6, 0xB5BD, 0xCEE7, 0xB5A5, 0xC8A1,
+  0xB9FE, 0xCBC4, 0xBBD8, 0xB4F3, 0xCDB7, 0xB4E6, 0xB6A8, 0xBECD,
+  0xC6A8, 0xB8DA, 0xB2EE, 0xC4EA, 0xB6C8, 0xBFAA, 0xB5C3, 0xB8D2,
+  0xC8D5, 0xCAB1, 0xD0C7, 0xD4C2, 0xC6DA, 0xD0A3, 0xCFFB, 0xCEC2,
+  0xB5E3, 0xCBAF, 0xC8B7, 0xC0EB, 0xC3EB, 0xD7EF, 0xD6C3, 0xD1FC,
+  0xB6A9, 0xC9E8, 0xB9F2, 0xB7B5, 0xD6D3, 0xBCE4, 0xC4D6, 0xC5E3,
+};
+
+#endif
@@ -0,0 +1,99 @@
+#include <Arduino.h>
+#include "driver_st7920.h"
+#include "driver_at24c32.h"
+#include "glyph_cache.h"
+
+
+#define NONE_GLYPH_CACHE 0xFF // id of an empty entry or slot
+
+// Bitmaps in RAM and when they were used last time.
+static byte entryIds_GlyphCache[ENTRIES_GLYPH_CACHE];
+static byte entryUses_GlyphCache[ENTRIES_GLYPH_CACHE];
+static byte entries_GlyphCache[ENTRIES_GLYPH_CACHE][GLYPH_SIZE_GLYPH_CACHE];
+
+// Glyphs in CGRAM slots of ST7920 and when they were used last time.
+static byte slotIds_GlyphCache[4];
+static byte slotUses_GlyphCache[4];
+
+static byte clock_GlyphCache = 0; // increases on each use, ages are compared with wrap-around
+
+
+void initialize_GlyphCache() {
+  memset(entryIds_GlyphCache, NONE_GLYPH_CACHE, sizeof(entryIds_GlyphCache));
+  memset(slotIds_GlyphCache, NONE_GLYPH_CACHE, sizeof(slotIds_GlyphCache));
+}
+
+
+bool storeGlyph_GlyphCache(byte id, const byte bitmap[]) {
+  if (id >= GLYPHS_GLYPH_CACHE) return false;
+  for (byte i = 0; i < ENTRIES_GLYPH_CACHE; i++)
+    if (entryIds_GlyphCache[i] == id) memcpy(entries_GlyphCache[i], bitmap, GLYPH_SIZE_GLYPH_CACHE);
+  for (byte i = 0; i < 4; i++)
+    if (slotIds_GlyphCache[i] == id) slotIds_GlyphCache[i] = NONE_GLYPH_CACHE; // upload again when printed
+  return writeBytes_AT24C32(START_GLYPH_CACHE + id * GLYPH_SIZE_GLYPH_CACHE, bitmap, GLYPH_SIZE_GLYPH_CACHE);
+}
+
+
+const byte *loadGlyph_GlyphCache(byte id) {
+  if (id >= GLYPHS_GLYPH_CACHE) return NULL;
+  clock_GlyphCache += 1;
+
+  byte oldest = 0;
+  for (byte i = 0; i < ENTRIES_GLYPH_CACHE; i++) {
+    if (entryIds_GlyphCache[i] == id) {
+      entryUses_GlyphCache[i] = clock_GlyphCache;
+      return entries_GlyphCache[i];
+    }
+    if ((byte)(clock_GlyphCache - entryUses_GlyphCache[i]) > (byte)(clock_GlyphCache - entryUses_GlyphCache[oldest]))
+      oldest = i;
+  }
+
+  // Miss: replace the least recently used entry, an empty entry is never used.
+  for (byte i = 0; i < ENTRIES_GLYPH_CACHE; i++)
+    if (entryIds_GlyphCache[i] == NONE_GLYPH_CACHE) oldest = i;
+  entryIds_GlyphCache[oldest] = NONE_GLYPH_CACHE;
+  if (!readBytes_AT24C32(START_GLYPH_CACHE + id * GLYPH_SIZE_GLYPH_CACHE,
+                         entries_GlyphCache[oldest], GLYPH_SIZE_GLYPH_CACHE)) return NULL;
+  entryIds_GlyphCache[oldest] = id;
+  entryUses_GlyphCache[oldest] = clock_GlyphCache;
+  return entries_GlyphCache[oldest];
+}
+
+
+bool printGlyph_GlyphCache(byte id, byte row, byte column) {
+  clock_GlyphCache += 1;
+  byte slot = NONE_GLYPH_CACHE;
+
+  for (byte i = 0; i < 4; i++)
+    if (slotIds_GlyphCache[i] == id) slot = i;
+
+  if (slot == NONE_GLYPH_CACHE) {
+    // Replace the least recently used slot which is not on the display.
+    for (byte i = 0; i < 4; i++) {
+      if (slotIds_GlyphCache[i] != NONE_GLYPH_CACHE && isGlyphShown_ST7920(i)) continue;
+      if (slot == NONE_GLYPH_CACHE || slotIds_GlyphCache[i] == NONE_GLYPH_CACHE ||
+          (byte)(clock_GlyphCache - slotUses_GlyphCache[i]) > (byte)(clock_GlyphCache - slotUses_GlyphCache[slot]))
+        slot = i;
+      if (slotIds_GlyphCache[i] == NONE_GLYPH_CACHE) break;
+    }
+    if (slot == NONE_GLYPH_CACHE) return false;
+
+    const byte *bitmap = loadGlyph_GlyphCache(id);
+    if (bitmap == NULL) return false;
+    setGlyph_ST7920(slot, bitmap);
+    slotIds_GlyphCache[slot] = id;
+  }
+
+  slotUses_GlyphCache[slot] = clock_GlyphCache;
+  short code = GLYPH_ST7920(slot);
+  printFullCharacters_ST7920(&code, 1, row, column);
+  return true;
+}
+
+
+bool drawGlyph_GlyphCache(byte id, byte x, byte y) {
+  const byte *bitmap = loadGlyph_GlyphCache(id);
+  if (bitmap == NULL) return false;
+  drawBitmap_ST7920(bitmap, x, y, 16, 16);
+  return true;
+}
@@ -0,0 +1,38 @@
+#ifndef GLYPH_CACHE_H
+#define GLYPH_CACHE_H
+
+
+/* Custom 16*16 glyphs (e.g. 7-segment style digits) stored in the AT24C32.
+   Bitmaps are staged through a small LRU cache in RAM, and the glyphs in use are kept
+   in the 4 CGRAM slots of ST7920 with LRU replacement, so a glyph shown repeatedly is
+   uploaded once and then printed by character code like any built-in character. */
+
+
+#include <Arduino.h>
+
+
+#define START_GLYPH_CACHE 0x0C00 // first address of glyph area in AT24C32, after the event log
+#define GLYPHS_GLYPH_CACHE 28 // glyphs in EEPROM, 32 bytes each, up to 0x0F80
+#define GLYPH_SIZE_GLYPH_CACHE 32 // bytes of a 16*16 bitmap
+#define ENTRIES_GLYPH_CACHE 2 // bitmaps kept in RAM
+
+
+void initialize_GlyphCache();
+
+/* Save a bitmap as glyph id (0 to GLYPHS_GLYPH_CACHE - 1) in the EEPROM.
+   bitmap: 16 rows of 2 bytes, MSB is the leftmost pixel. */
+bool storeGlyph_GlyphCache(byte id, const byte bitmap[]);
+
+/* Get the bitmap of glyph id, from RAM if cached, otherwise from EEPROM.
+   The pointer stays valid until the next load. Return NULL when it can't be read. */
+const byte *loadGlyph_GlyphCache(byte id);
+
+/* Print glyph id as a full character at row (0-3) and column.
+   It's uploaded to CGRAM first unless a slot holds it already.
+   Return false when all 4 slots are shown on the display and none can be replaced. */
+bool printGlyph_GlyphCache(byte id, byte row, byte column);
+
+// Draw glyph id into the framebuffer at pixel (x, y).
+bool drawGlyph_GlyphCache(byte id, byte x, byte y);
+
+#endif
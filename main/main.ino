@@ -1,11 +1,112 @@
 #include <SPI.h>
+#include <avr/wdt.h>
 #include "driver_st7920.h"
+#include "driver_twi.h"
+#include "driver_ds3231.h"
+#include "driver_at24c32.h"
+#include "event_log.h"
+#include "calibration.h"
+#include "clock_face.h"
+#include "scheduler.h"
+#include "console.h"
+#include "esp_link.h"
+#include "profiler.h"
+#include "pacing.h"
+#include "benchmark_st7920.h"
+
+#define RUN_BENCHMARK false // true - print display throughput over Serial instead of running the clock
+
+#define FLUSH_ROWS 4 // framebuffer rows sent by one run of display task
+
+/* A hung loop is reset by the watchdog, and the display comes back by warm start (see initialize_ST7920()).
+   Longest wait in the loop is a few ms (EEPROM write cycle, display clear), calibration turns it off. */
+#define WATCHDOG_TIMEOUT WDTO_2S
+
+static byte tickTask; // released by SQW tick
+static byte renderTask; // released when the time read by tickTask arrives
+static byte displayTask; // released again as soon as the display queue runs empty while flushing
+static bool flushing = false; // rows of the framebuffer are left, or the last of them are still in the queue
+
+
+// Queue a burst read of the RTC once per tick, the CPU doesn't wait for the bus.
+static void runTick() {
+  requestTime_DS3231();
+}
+
+
+// Draw the changed digits into framebuffer.
+static void runRender() {
+  Time_DS3231 time;
+  getTime_DS3231(&time);
+  render_ClockFace(&time);
+  mark_Pacing(RENDER_PACING, micros());
+  triggerTask_Scheduler(displayTask);
+}
+
+
+/* Send a few rows of changed framebuffer when the display queue is empty, never waits for it.
+   While flushing, loop() releases it again the moment the queue drains, so the panel isn't left idle
+   until the next period. The frame has reached the panel once nothing is left and the queue ran empty. */
+static void runDisplay() {
+  if (isBusy_ST7920()) return;
+  flushing = !flushFramebufferRows_ST7920(FLUSH_ROWS) || isBusy_ST7920();
+  if (!flushing) mark_Pacing(FLUSH_PACING, getIdleMicros_ST7920());
+}
+
+
+static void runLog() {
+  append_EventLog(TEMPERATURE_EVENT_LOG, 0);
+}
+
 
 void setup () {
   Serial.begin(9600);
-  test();
+  initialize_Profiler();
+#if RUN_BENCHMARK
+  benchmark_ST7920();
+#else
+  initialize_AT24C32();
+  load_Calibration(); // SPI timing of this display module, if it was calibrated
+  bool warm = initialize_ST7920();
+  initialize_DS3231();
+  initialize_EventLog();
+  append_EventLog(BOOT_EVENT_LOG, warm); // data: 1 - warm start, the display kept its content
+  startTick_DS3231();
+  if (warm) invalidate_ClockFace(); // digits are still in the framebuffer, redrawing them changes nothing
+  else initialize_ClockFace();
+  initialize_EspLink();
+
+  tickTask = addTask_Scheduler(runTick, F("tick"), 0, 0, 100);
+  renderTask = addTask_Scheduler(runRender, F("render"), 0, 0, 100);
+  displayTask = addTask_Scheduler(runDisplay, F("display"), 1, 5, 20); // the period catches drawing by other tasks
+  addTask_Scheduler(runLog, F("log"), 2, 600000, 1000);
+  addTask_Scheduler(poll_EspLink, F("link"), 2, 5, 50);
+  addTask_Scheduler(poll_Console, F("console"), 3, 50, 100);
+  wdt_enable(WATCHDOG_TIMEOUT);
+#endif
 }
 
 void loop () {
-  ;
-}
\ No newline at end of file
+#if !RUN_BENCHMARK
+  wdt_reset();
+  if (takeTick_DS3231()) {
+    mark_Pacing(TICK_PACING, getTickMicros_DS3231());
+    triggerTask_Scheduler(tickTask);
+  }
+  if (takeTime_DS3231()) {
+    mark_Pacing(READ_PACING, getSnapshotMicros_DS3231());
+    triggerTask_Scheduler(renderTask);
+  }
+  if (flushing && !isBusy_ST7920()) triggerTask_Scheduler(displayTask);
+  if (takeCalibration_Console()) {
+    // Blocks for minutes while the display shows test patterns, so it doesn't run as a task.
+    wdt_disable();
+    run_Calibration();
+    initialize_ClockFace();
+    skipFrame_Pacing();
+    wdt_enable(WATCHDOG_TIMEOUT);
+    return;
+  }
+  if (!runTasks_Scheduler()) sleepUntilTick_DS3231();
+#endif
+}
@@ -0,0 +1,109 @@
+#include <Arduino.h>
+#include "pacing.h"
+
+
+struct Latency_Pacing {
+  unsigned long minimum; // us from the tick
+  unsigned long maximum;
+  unsigned long total;
+};
+
+static unsigned long times_Pacing[STAGES_PACING]; // when each stage of the current frame happened
+static byte reached_Pacing = 0; // stages marked in the current frame, 0 before the first tick
+static unsigned long frames_Pacing = 0; // frames that reached the panel
+static unsigned long overruns_Pacing = 0;
+static Latency_Pacing latencies_Pacing[STAGES_PACING - 1] = { // stages after the tick
+  {0xFFFFFFFF, 0, 0}, {0xFFFFFFFF, 0, 0}, {0xFFFFFFFF, 0, 0}};
+static unsigned long histogram_Pacing[BUCKETS_PACING];
+
+static const char name0_Pacing[] PROGMEM = "read";
+static const char name1_Pacing[] PROGMEM = "render";
+static const char name2_Pacing[] PROGMEM = "flush";
+static const char *const names_Pacing[STAGES_PACING - 1] PROGMEM = {
+  name0_Pacing, name1_Pacing, name2_Pacing
+};
+
+
+static void record_Pacing() {
+  frames_Pacing += 1;
+  for (byte stage = 1; stage < STAGES_PACING; stage++) {
+    unsigned long latency = times_Pacing[stage] - times_Pacing[TICK_PACING];
+    Latency_Pacing *record = &latencies_Pacing[stage - 1];
+    if (latency < record->minimum) record->minimum = latency;
+    if (latency > record->maximum) record->maximum = latency;
+    record->total += latency;
+  }
+
+  unsigned long milliseconds = (times_Pacing[FLUSH_PACING] - times_Pacing[TICK_PACING]) / 1000;
+  byte bucket = 0;
+  while (milliseconds > 0 && bucket < BUCKETS_PACING - 1) {
+    milliseconds >>= 1;
+    bucket += 1;
+  }
+  histogram_Pacing[bucket] += 1;
+}
+
+
+void mark_Pacing(byte stage, unsigned long time) {
+  if (stage == TICK_PACING) {
+    if (reached_Pacing > 0 && reached_Pacing < STAGES_PACING) overruns_Pacing += 1;
+    times_Pacing[TICK_PACING] = time;
+    reached_Pacing = 1;
+    return;
+  }
+  if (stage != reached_Pacing) return;
+
+  // The display may have gone idle before the render, when it had nothing to send.
+  if ((long)(time - times_Pacing[stage - 1]) < 0) time = times_Pacing[stage - 1];
+  times_Pacing[stage] = time;
+  reached_Pacing += 1;
+  if (reached_Pacing == STAGES_PACING) record_Pacing();
+}
+
+
+void report_Pacing(Print &output) {
+  output.print(F("frames: "));
+  output.print(frames_Pacing);
+  output.print(F(", overruns: "));
+  output.println(overruns_Pacing);
+  if (frames_Pacing == 0) return;
+
+  output.println(F("stage: min us, avg us, max us from tick"));
+  for (byte i = 0; i < STAGES_PACING - 1; i++) {
+    output.print((const __FlashStringHelper *)pgm_read_ptr(&names_Pacing[i]));
+    output.print(F(": "));
+    output.print(latencies_Pacing[i].minimum);
+    output.print(F(", "));
+    output.print(latencies_Pacing[i].total / frames_Pacing);
+    output.print(F(", "));
+    output.println(latencies_Pacing[i].maximum);
+  }
+
+  output.println(F("tick to flush ms: frames"));
+  for (byte bucket = 0; bucket < BUCKETS_PACING; bucket++) {
+    if (bucket == 0) output.print(F("<1"));
+    else if (bucket == BUCKETS_PACING - 1) output.print(F(">="));
+    else output.print(1UL << (bucket - 1));
+    if (bucket > 0 && bucket < BUCKETS_PACING - 1) output.print('-');
+    if (bucket > 0) output.print(1UL << (bucket == BUCKETS_PACING - 1 ? bucket - 1 : bucket));
+    output.print(F(": "));
+    output.println(histogram_Pacing[bucket]);
+  }
+}
+
+
+void skipFrame_Pacing() {
+  reached_Pacing = 0;
+}
+
+
+void reset_Pacing() {
+  frames_Pacing = 0;
+  overruns_Pacing = 0;
+  for (byte i = 0; i < STAGES_PACING - 1; i++) {
+    latencies_Pacing[i].minimum = 0xFFFFFFFF;
+    latencies_Pacing[i].maximum = 0;
+    latencies_Pacing[i].total = 0;
+  }
+  memset(histogram_Pacing, 0, sizeof(histogram_Pacing));
+}
@@ -0,0 +1,39 @@
+#ifndef PACING_H
+#define PACING_H
+
+
+/* Latency of the tick-to-pixel pipeline, one frame per SQW tick:
+   tick interrupt -> RTC read done -> digits rendered -> last byte of them executed by the panel.
+   Each stage is measured from the tick, with minimum, average and maximum in microseconds,
+   and the whole latency also goes into a histogram with power of 2 buckets.
+   A frame that hasn't reached the panel when the next tick comes is counted as an overrun. */
+
+
+#include <Arduino.h>
+
+
+// Stages in pipeline order.
+#define TICK_PACING 0
+#define READ_PACING 1
+#define RENDER_PACING 2
+#define FLUSH_PACING 3
+#define STAGES_PACING 4
+
+/* Bucket 0 holds latencies below 1 ms, bucket n (1-6) those from 2^(n-1) to 2^n ms,
+   the last one everything from 64 ms. */
+#define BUCKETS_PACING 8
+
+/* Stage of the current frame happened at time (micros()).
+   TICK_PACING starts a new frame, any other stage is ignored unless the previous one
+   is marked already, so it's fine to mark FLUSH_PACING every time the display is idle. */
+void mark_Pacing(byte stage, unsigned long time);
+
+// Print frames, overruns, latency of each stage and the histogram.
+void report_Pacing(Print &output);
+
+void reset_Pacing();
+
+// Forget the current frame without counting it, for pauses of the pipeline like calibration.
+void skipFrame_Pacing();
+
+#endif
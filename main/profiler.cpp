@@ -0,0 +1,90 @@
+#include <Arduino.h>
+#include "profiler.h"
+
+#if PROFILER_ENABLED
+
+static Counter_Profiler counters_Profiler[PROBES_PROFILER];
+volatile static unsigned short overflows_Profiler = 0; // upper 16 bits of cycle count
+
+static const char name0_Profiler[] PROGMEM = "sendInstruction";
+static const char name1_Profiler[] PROGMEM = "sendData";
+static const char name2_Profiler[] PROGMEM = "setCursor";
+static const char name3_Profiler[] PROGMEM = "flushCells";
+static const char name4_Profiler[] PROGMEM = "printHalf";
+static const char name5_Profiler[] PROGMEM = "printFull";
+static const char name6_Profiler[] PROGMEM = "flushFramebuffer";
+static const char name7_Profiler[] PROGMEM = "spiTransfer";
+static const char name8_Profiler[] PROGMEM = "i2cRead";
+static const char name9_Profiler[] PROGMEM = "i2cWrite";
+static const char *const names_Profiler[PROBES_PROFILER] PROGMEM = {
+  name0_Profiler, name1_Profiler, name2_Profiler, name3_Profiler, name4_Profiler,
+  name5_Profiler, name6_Profiler, name7_Profiler, name8_Profiler, name9_Profiler
+};
+
+
+ISR(TIMER1_OVF_vect) {
+  overflows_Profiler += 1;
+}
+
+
+void initialize_Profiler() {
+  TCCR1A = 0;
+  TCCR1B = 1 << CS10; // normal mode, no prescaler: one count per CPU cycle
+  TIFR1 = 1 << TOV1;
+  TIMSK1 = 1 << TOIE1;
+  reset_Profiler();
+}
+
+
+/* An overflow may be pending while interrupts are off (inside another ISR or enqueue),
+   so the flag is checked together with the counter. */
+unsigned long readCycles_Profiler() {
+  byte oldSREG = SREG;
+  cli();
+  unsigned short low = TCNT1;
+  unsigned short high = overflows_Profiler;
+  if ((TIFR1 & (1 << TOV1)) && low < 0x8000) high += 1;
+  SREG = oldSREG;
+  return ((unsigned long)high << 16) | low;
+}
+
+
+void record_Profiler(byte probe, unsigned long cycles) {
+  byte oldSREG = SREG;
+  cli();
+  Counter_Profiler *counter = &counters_Profiler[probe];
+  counter->calls += 1;
+  counter->totalCycles += cycles;
+  if (cycles > counter->maxCycles) counter->maxCycles = cycles;
+  SREG = oldSREG;
+}
+
+
+void report_Profiler(Print &output) {
+  output.println(F("probe: calls, total cycles, max cycles"));
+  for (byte i = 0; i < PROBES_PROFILER; i++) {
+    Counter_Profiler counter;
+    byte oldSREG = SREG;
+    cli();
+    counter = counters_Profiler[i];
+    SREG = oldSREG;
+    if (counter.calls == 0) continue;
+    output.print((const __FlashStringHelper *)pgm_read_ptr(&names_Profiler[i]));
+    output.print(F(": "));
+    output.print(counter.calls);
+    output.print(F(", "));
+    output.print(counter.totalCycles);
+    output.print(F(", "));
+    output.println(counter.maxCycles);
+  }
+}
+
+
+void reset_Profiler() {
+  byte oldSREG = SREG;
+  cli();
+  memset(counters_Profiler, 0, sizeof(counters_Profiler));
+  SREG = oldSREG;
+}
+
+#endif
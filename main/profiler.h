@@ -0,0 +1,68 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+
+/* Call counts, total and maximum CPU cycles of driver entry points and transports.
+   Cycles are counted by Timer1 running at the CPU clock, overflows extend it to 32 bits.
+   A probe measures its enclosing block including nested probes, so the numbers of
+   a caller contain those of its callees.
+   With PROFILER_ENABLED false every probe compiles to nothing and Timer1 is left alone. */
+
+
+#include <Arduino.h>
+
+
+#define PROFILER_ENABLED false // true - count cycles, uses Timer1
+
+// Probe ids, the names printed by report_Profiler() follow this order.
+#define SEND_INSTRUCTION_PROFILER 0
+#define SEND_DATA_PROFILER 1
+#define SET_CURSOR_PROFILER 2
+#define FLUSH_CELLS_PROFILER 3
+#define PRINT_HALF_PROFILER 4
+#define PRINT_FULL_PROFILER 5
+#define FLUSH_FRAMEBUFFER_PROFILER 6
+#define SPI_TRANSFER_PROFILER 7
+#define I2C_READ_PROFILER 8
+#define I2C_WRITE_PROFILER 9
+#define PROBES_PROFILER 10
+
+#if PROFILER_ENABLED
+
+struct Counter_Profiler {
+  unsigned long calls;
+  unsigned long totalCycles;
+  unsigned long maxCycles;
+};
+
+unsigned long readCycles_Profiler();
+void record_Profiler(byte probe, unsigned long cycles);
+
+// Measure from the declaration to the end of the enclosing block, whichever way it's left.
+struct Probe_Profiler {
+  byte probe;
+  unsigned long start;
+  Probe_Profiler(byte id) : probe(id), start(readCycles_Profiler()) {}
+  ~Probe_Profiler() { record_Profiler(probe, readCycles_Profiler() - start); }
+};
+
+#define PROBE_PROFILER(id) Probe_Profiler probe_Profiler(id)
+
+// Start Timer1 and clear the counters.
+void initialize_Profiler();
+
+// Print calls, total and maximum cycles of every probe that was called.
+void report_Profiler(Print &output);
+
+void reset_Profiler();
+
+#else
+
+#define PROBE_PROFILER(id)
+inline void initialize_Profiler() {}
+inline void report_Profiler(Print &output) { output.println(F("profiler disabled")); }
+inline void reset_Profiler() {}
+
+#endif
+
+#endif
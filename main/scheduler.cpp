@@ -0,0 +1,91 @@
+#include <Arduino.h>
+#include "scheduler.h"
+
+
+static Task_Scheduler tasks_Scheduler[TASKS_SCHEDULER];
+static byte count_Scheduler = 0;
+
+
+byte addTask_Scheduler(Function_Scheduler function, const __FlashStringHelper *name,
+                       byte priority, unsigned long period, unsigned long deadline) {
+  if (count_Scheduler >= TASKS_SCHEDULER) return 0xFF;
+  Task_Scheduler *task = &tasks_Scheduler[count_Scheduler];
+  memset(task, 0, sizeof(Task_Scheduler));
+  task->function = function;
+  task->name = name;
+  task->priority = priority;
+  task->period = period;
+  task->deadline = deadline;
+  task->released = millis();
+  return count_Scheduler++;
+}
+
+
+void triggerTask_Scheduler(byte id) {
+  if (id >= count_Scheduler || tasks_Scheduler[id].ready) return;
+  tasks_Scheduler[id].ready = true;
+  tasks_Scheduler[id].released = millis();
+}
+
+
+// Release periodic tasks whose period elapsed.
+static void releaseTasks_Scheduler(unsigned long now) {
+  for (byte i = 0; i < count_Scheduler; i++) {
+    Task_Scheduler *task = &tasks_Scheduler[i];
+    if (task->ready || task->period == 0 || now - task->released < task->period) continue;
+    task->ready = true;
+    // Keep the phase, unless the task fell more than one period behind.
+    task->released = now - task->released < 2 * task->period ? task->released + task->period : now;
+  }
+}
+
+
+bool runTasks_Scheduler() {
+  unsigned long now = millis();
+  releaseTasks_Scheduler(now);
+
+  Task_Scheduler *chosen = NULL;
+  for (byte i = 0; i < count_Scheduler; i++) {
+    Task_Scheduler *task = &tasks_Scheduler[i];
+    if (!task->ready) continue;
+    if (chosen == NULL || task->priority < chosen->priority ||
+        (task->priority == chosen->priority &&
+         (long)(task->released + task->deadline - (chosen->released + chosen->deadline)) < 0))
+      chosen = task;
+  }
+  if (chosen == NULL) return false;
+
+  chosen->ready = false;
+  unsigned long start = micros();
+  chosen->function();
+  unsigned long time = micros() - start;
+
+  chosen->runs += 1;
+  if (time > chosen->worstTime) chosen->worstTime = time;
+  if (millis() - chosen->released > chosen->deadline) chosen->misses += 1;
+  return true;
+}
+
+
+void report_Scheduler(Print &output) {
+  output.println(F("task: runs, worst us, deadline misses"));
+  for (byte i = 0; i < count_Scheduler; i++) {
+    Task_Scheduler *task = &tasks_Scheduler[i];
+    output.print(task->name);
+    output.print(F(": "));
+    output.print(task->runs);
+    output.print(F(", "));
+    output.print(task->worstTime);
+    output.print(F(", "));
+    output.println(task->misses);
+  }
+}
+
+
+void resetCounters_Scheduler() {
+  for (byte i = 0; i < count_Scheduler; i++) {
+    tasks_Scheduler[i].runs = 0;
+    tasks_Scheduler[i].worstTime = 0;
+    tasks_Scheduler[i].misses = 0;
+  }
+}
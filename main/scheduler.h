@@ -0,0 +1,51 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+
+/* Cooperative run-to-completion scheduler.
+   A task is a function doing a bounded piece of work and returning.
+   It becomes ready when its period elapses or when it's triggered (e.g. by an interrupt flag).
+   Among ready tasks the one with the lowest priority number runs first,
+   equal priorities are ordered by deadline (release time + deadline). */
+
+
+#include <Arduino.h>
+
+
+#define TASKS_SCHEDULER 8 // maximum number of tasks
+
+typedef void (*Function_Scheduler)();
+
+struct Task_Scheduler {
+  Function_Scheduler function;
+  const __FlashStringHelper *name; // shown in report
+  unsigned long period; // ms between releases, 0 - only released by trigger
+  unsigned long deadline; // ms after release the task should have finished
+  unsigned long released; // millis() of the last release
+  byte priority; // 0 is the highest
+  bool ready; // released and not run yet
+  unsigned long runs; // number of runs
+  unsigned long worstTime; // longest run in us
+  unsigned long misses; // runs finished after deadline
+};
+
+
+/* Add a task, return its id for triggerTask_Scheduler().
+   Return 0xFF when there is no room for more tasks. */
+byte addTask_Scheduler(Function_Scheduler function, const __FlashStringHelper *name,
+                       byte priority, unsigned long period, unsigned long deadline);
+
+// Release a task now, regardless of its period. Not to be called in interrupts.
+void triggerTask_Scheduler(byte id);
+
+/* Run the most urgent ready task once.
+   Return false when no task is ready, so that the caller may sleep. */
+bool runTasks_Scheduler();
+
+// Print runs, worst case run time and deadline misses of every task.
+void report_Scheduler(Print &output);
+
+// Clear the counters of every task.
+void resetCounters_Scheduler();
+
+#endif
@@ -0,0 +1,200 @@
+#include <Arduino.h>
+#include "driver_ds3231.h"
+#include "time_sync.h"
+
+
+static Time_DS3231 time_TimeSync; // network time of the held sample, whole seconds
+static unsigned long microseconds_TimeSync; // and the part of a second
+static unsigned long moment_TimeSync; // micros() when it was valid
+static bool held_TimeSync = false;
+static unsigned long written_TimeSync = 0; // micros() when the time registers were written last time
+
+// Time write waiting for a network second boundary.
+static bool writing_TimeSync = false;
+static unsigned long writeMoment_TimeSync; // micros() when the network second begins
+static unsigned long writeSeconds_TimeSync; // network seconds since 2000 then
+static byte writeDay_TimeSync; // day of week then
+
+static unsigned long samples_TimeSync = 0;
+static unsigned long writes_TimeSync = 0;
+static unsigned long corrections_TimeSync = 0;
+static long lastError_TimeSync = 0; // us
+static float lastDrift_TimeSync = 0; // ppm fitted by the last full batch
+
+/* Least squares fit of error (ms) over time (hours since the first sample of the batch),
+   hours keep the float sums well away from rounding. */
+static unsigned long batchStart_TimeSync; // network seconds of the first sample
+static unsigned short batchSamples_TimeSync = 0;
+static float sumTime_TimeSync, sumError_TimeSync, sumSquare_TimeSync, sumProduct_TimeSync;
+
+static const unsigned short daysBefore_TimeSync[12] PROGMEM = {
+  0, 31, 59, 90, 120, 151, 181, 212, 243, 273, 304, 334};
+
+
+static bool isBCD_TimeSync(byte value, byte low, byte high) {
+  return (value & 0b00001111) <= 9 && value >= low && value <= high;
+}
+
+
+static bool isValid_TimeSync(const Time_DS3231 *time) {
+  return isBCD_TimeSync(time->seconds, 0x00, 0x59) && isBCD_TimeSync(time->minutes, 0x00, 0x59) &&
+         isBCD_TimeSync(time->hours, 0x00, 0x23) && time->day >= 1 && time->day <= 7 &&
+         isBCD_TimeSync(time->date, 0x01, 0x31) && isBCD_TimeSync(time->month & 0b00011111, 0x01, 0x12) &&
+         isBCD_TimeSync(time->year, 0x00, 0x99);
+}
+
+
+// Seconds since 2000-01-01 00:00:00, the century bit is ignored.
+static unsigned long seconds_TimeSync(const Time_DS3231 *time) {
+  byte year = bcdToDecimal_DS3231(time->year);
+  byte month = bcdToDecimal_DS3231(time->month & 0b00011111);
+  unsigned long days = year * 365UL + (year + 3) / 4 + pgm_read_word(&daysBefore_TimeSync[month - 1]) +
+                       bcdToDecimal_DS3231(time->date) - 1;
+  if (month > 2 && year % 4 == 0) days += 1;
+  return ((days * 24 + bcdToDecimal_DS3231(time->hours)) * 60 + bcdToDecimal_DS3231(time->minutes)) * 60 +
+         bcdToDecimal_DS3231(time->seconds);
+}
+
+
+static void restartBatch_TimeSync() {
+  batchSamples_TimeSync = 0;
+  sumTime_TimeSync = sumError_TimeSync = sumSquare_TimeSync = sumProduct_TimeSync = 0;
+}
+
+
+static void addSample_TimeSync(unsigned long seconds, long error) {
+  if (batchSamples_TimeSync == 0) batchStart_TimeSync = seconds;
+  float hours = (seconds - batchStart_TimeSync) / 3600.0;
+  float milliseconds = error / 1000.0;
+  batchSamples_TimeSync += 1;
+  sumTime_TimeSync += hours;
+  sumError_TimeSync += milliseconds;
+  sumSquare_TimeSync += hours * hours;
+  sumProduct_TimeSync += hours * milliseconds;
+  if (seconds - batchStart_TimeSync < BATCH_HOURS_TIME_SYNC * 3600UL) return;
+  if (batchSamples_TimeSync < MIN_SAMPLES_TIME_SYNC) return;
+
+  float samples = batchSamples_TimeSync;
+  float denominator = samples * sumSquare_TimeSync - sumTime_TimeSync * sumTime_TimeSync;
+  float slope = (samples * sumProduct_TimeSync - sumTime_TimeSync * sumError_TimeSync) / denominator;
+  restartBatch_TimeSync();
+  addSample_TimeSync(seconds, error); // this sample opens the next batch
+  if (denominator <= 0) return;
+
+  // 1 ms per hour is 1000 us in 3600 s, 0.278 ppm. A fast RTC needs a larger offset.
+  lastDrift_TimeSync = slope / 3.6;
+  long steps = lround(lastDrift_TimeSync / PPM_PER_STEP_TIME_SYNC);
+  steps = constrain(steps, -MAX_STEP_TIME_SYNC, MAX_STEP_TIME_SYNC);
+  if (steps == 0) return;
+  int offset = readAgingOffset_DS3231() + steps;
+  writeAgingOffset_DS3231(constrain(offset, -128, 127));
+  corrections_TimeSync += 1;
+}
+
+
+bool submit_TimeSync(const Time_DS3231 *time, unsigned long microseconds, unsigned long moment) {
+  if (!isValid_TimeSync(time) || microseconds >= 1000000UL) return false;
+  time_TimeSync = *time;
+  microseconds_TimeSync = microseconds;
+  moment_TimeSync = moment;
+  held_TimeSync = true;
+  return true;
+}
+
+
+// Inverse of seconds_TimeSync(), day of week is given.
+static void toTime_TimeSync(unsigned long seconds, byte day, Time_DS3231 *time) {
+  time->seconds = decimalToBCD_DS3231(seconds % 60);
+  time->minutes = decimalToBCD_DS3231(seconds / 60 % 60);
+  time->hours = decimalToBCD_DS3231(seconds / 3600 % 24);
+  time->day = day;
+  unsigned short days = seconds / 86400;
+  byte year = 0;
+  while (days >= (year % 4 == 0 ? 366 : 365)) days -= year++ % 4 == 0 ? 366 : 365;
+  byte month = 12;
+  while (pgm_read_word(&daysBefore_TimeSync[month - 1]) + (month > 2 && year % 4 == 0) > days) month--;
+  time->date = decimalToBCD_DS3231(days - pgm_read_word(&daysBefore_TimeSync[month - 1]) -
+                                   (month > 2 && year % 4 == 0) + 1);
+  time->month = decimalToBCD_DS3231(month);
+  time->year = decimalToBCD_DS3231(year);
+}
+
+
+/* Writing the seconds register restarts the countdown of the RTC, so it's written right when
+   a network second begins. The wait is left to later polls, only its last few ms are spun. */
+static void write_TimeSync() {
+  long remaining = (long)(writeMoment_TimeSync - micros());
+  if (remaining > SPIN_TIME_SYNC) return;
+  if (remaining < -1000L) {
+    // The poll came too late, take the next second.
+    writeMoment_TimeSync += 1000000UL;
+    writeSeconds_TimeSync += 1;
+    writeDay_TimeSync = writeDay_TimeSync % 7 + 1;
+    return;
+  }
+  Time_DS3231 time;
+  toTime_TimeSync(writeSeconds_TimeSync, writeDay_TimeSync, &time);
+  while ((long)(micros() - writeMoment_TimeSync) < 0);
+  setTime_DS3231(&time);
+  written_TimeSync = micros();
+  writes_TimeSync += 1;
+  writing_TimeSync = false;
+  restartBatch_TimeSync();
+}
+
+
+bool poll_TimeSync(long *error) {
+  if (writing_TimeSync) {
+    write_TimeSync();
+    return false;
+  }
+  if (!held_TimeSync) return false;
+  unsigned long tick = getTickMicros_DS3231();
+  // The snapshot must be the second that started at the last tick, and that tick must come after a write.
+  if ((long)(getSnapshotMicros_DS3231() - tick) < 0 || (writes_TimeSync > 0 && (long)(tick - written_TimeSync) < 0)) {
+    if (micros() - moment_TimeSync > MAX_WAIT_TIME_SYNC * 1000UL) held_TimeSync = false;
+    return false;
+  }
+  held_TimeSync = false;
+  samples_TimeSync += 1;
+
+  Time_DS3231 rtc;
+  getTime_DS3231(&rtc);
+  unsigned long seconds = seconds_TimeSync(&time_TimeSync);
+  long difference = isValid_TimeSync(&rtc) ? (long)(seconds_TimeSync(&rtc) - seconds) : 2000;
+  difference = constrain(difference, -2000, 2000); // keeps the error in range of long
+  *error = difference * 1000000L + (long)(moment_TimeSync - tick) - (long)microseconds_TimeSync;
+  lastError_TimeSync = *error;
+
+  if (labs(*error) < RESYNC_TIME_SYNC) {
+    addSample_TimeSync(seconds, *error);
+    return true;
+  }
+
+  // Network time is seconds + microseconds at moment, find the next whole second after now.
+  unsigned long elapsed = micros() - moment_TimeSync + microseconds_TimeSync; // us since that network second began
+  unsigned long ahead = elapsed / 1000000UL + 1;
+  writeMoment_TimeSync = moment_TimeSync - microseconds_TimeSync + ahead * 1000000UL;
+  writeSeconds_TimeSync = seconds + ahead;
+  writeDay_TimeSync = (time_TimeSync.day - 1 + (writeSeconds_TimeSync / 86400 - seconds / 86400)) % 7 + 1;
+  writing_TimeSync = true;
+  return true;
+}
+
+
+void report_TimeSync(Print &output) {
+  output.print(F("samples: "));
+  output.print(samples_TimeSync);
+  output.print(F(", last error us: "));
+  output.println(lastError_TimeSync);
+  output.print(F("time writes: "));
+  output.print(writes_TimeSync);
+  output.print(F(", aging corrections: "));
+  output.print(corrections_TimeSync);
+  output.print(F(", aging offset: "));
+  output.println(readAgingOffset_DS3231());
+  output.print(F("batch samples: "));
+  output.print(batchSamples_TimeSync);
+  output.print(F(", last drift ppm: "));
+  output.println(lastDrift_TimeSync, 3);
+}
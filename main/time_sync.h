@@ -0,0 +1,46 @@
+#ifndef TIME_SYNC_H
+#define TIME_SYNC_H
+
+
+/* Keep the DS3231 on network time delivered by esp_link.h.
+   Each sample compares the RTC with the network time at one moment on the Nano, the end of a time request:
+   the RTC time is the snapshot read after the last SQW tick plus the time elapsed since that tick,
+   the network time is what the ESP-12F timestamped when it received the request.
+   So a sample is as good as NTP over WiFi and the timestamp of the ESP-12F, a few ms,
+   poll timing of the Nano doesn't add to it. The tick timestamp of the INT0 interrupt can be late
+   by up to one byte time of the link (about 520 us) when SoftwareSerial was sending at the tick.
+   That is well within the sample noise, and the drift fit averages it out.
+   The time registers are written only when the RTC is off by RESYNC_TIME_SYNC or more
+   (first sync, battery change), at the start of a network second.
+   Smaller errors go into a batch instead, and once a batch spans
+   BATCH_HOURS_TIME_SYNC, the drift rate fitted to it corrects the aging offset of the DS3231
+   by one bounded step, so the RTC stops drifting rather than being set over and over. */
+
+
+#include <Arduino.h>
+#include "driver_ds3231.h"
+
+
+#define RESYNC_TIME_SYNC 200000L // us, errors from this are corrected by writing the time
+#define BATCH_HOURS_TIME_SYNC 24 // fit drift over this many hours, 0.1 ppm is about 9 ms a day
+/* Samples a batch needs for a correction. With 5 ms noise per sample, 48 samples spread over 24 hours
+   fit the drift to about 0.03 ppm, well below one aging step. */
+#define MIN_SAMPLES_TIME_SYNC 48
+#define MAX_STEP_TIME_SYNC 10 // most aging offset change of one batch (about 1 ppm)
+#define PPM_PER_STEP_TIME_SYNC 0.1 // effect of one aging offset step
+#define MAX_WAIT_TIME_SYNC 2000 // ms a sample waits for a snapshot read after the last tick
+#define SPIN_TIME_SYNC 10000L // us before a time write that are waited in place, polls come every 5 ms
+
+/* Network time (time and microseconds into its second) that was valid at moment (micros()).
+   The sample is held until the RTC snapshot matches the last tick, then poll_TimeSync() applies it.
+   Return false when the time is invalid. */
+bool submit_TimeSync(const Time_DS3231 *time, unsigned long microseconds, unsigned long moment);
+
+/* Apply a held sample once the snapshot is ready, and write the time when it's due, call it every few ms.
+   Return true when a sample was applied, error is RTC time minus network time (us) before correction. */
+bool poll_TimeSync(long *error);
+
+// Print samples, last error, time writes and aging corrections.
+void report_TimeSync(Print &output);
+
+#endif
@@ -0,0 +1,121 @@
+#!/usr/bin/env python3
+"""Compress a 1-bpp text-art font into the row RLE format of main/font.h.
+
+Usage: make_font.py <font.txt> <name> > main/font_<file>.h
+
+Input: '#' lines are comments, the first other line is "width height",
+then each glyph is a ": label" line followed by height lines of width
+characters, '#' for a set pixel and anything else for a clear one.
+Glyphs are numbered in the order they appear.
+
+Each pixel row becomes one of:
+  0b1nnnnnnn          the previous row again, n (1-127) times
+  0b0nnnnnnn r1 .. rn n run lengths, alternately clear and set starting
+                      with clear; pixels after the last run are clear
+"""
+
+import os
+import sys
+
+
+def read_font(path):
+    with open(path) as file:
+        lines = [line.rstrip('\n') for line in file if not line.startswith('#')]
+    lines = [line for line in lines if line.strip()]
+    width, height = map(int, lines[0].split())
+    glyphs = []
+    index = 1
+    while index < len(lines):
+        if not lines[index].startswith(':'):
+            sys.exit('%s: expected ": label", got %r' % (path, lines[index]))
+        label = lines[index][1:].strip()
+        rows = lines[index + 1:index + 1 + height]
+        if len(rows) != height or any(len(row) < width for row in rows):
+            sys.exit('%s: glyph %s is not %dx%d' % (path, label, width, height))
+        glyphs.append((label, [[c == '#' for c in row[:width]] for row in rows]))
+        index += 1 + height
+    return width, height, glyphs
+
+
+def encode_row(row):
+    runs = []
+    color = False
+    length = 0
+    for pixel in row:
+        if pixel == color:
+            length += 1
+        else:
+            runs.append(length)
+            color = pixel
+            length = 1
+    if color:
+        runs.append(length)  # a trailing clear run is implied
+    if len(runs) > 127:
+        sys.exit('row with %d runs can not be encoded' % len(runs))
+    return [len(runs)] + runs
+
+
+def encode_glyph(rows):
+    data = []
+    previous = None
+    repeats = 0
+    for row in rows:
+        if row == previous and repeats < 127:
+            repeats += 1
+            continue
+        if repeats:
+            data.append(0x80 | repeats)
+            repeats = 0
+        if row == previous:  # 127 repeats already emitted
+            repeats = 1
+            continue
+        data += encode_row(row)
+        previous = row
+    if repeats:
+        data.append(0x80 | repeats)
+    return data
+
+
+def main():
+    if len(sys.argv) != 3:
+        sys.exit(__doc__)
+    path, name = sys.argv[1], sys.argv[2]
+    width, height, glyphs = read_font(path)
+
+    offsets = []
+    data = []
+    for label, rows in glyphs:
+        offsets.append(len(data))
+        data += encode_glyph(rows)
+
+    guard = 'FONT_' + os.path.splitext(os.path.basename(path))[0].upper() + '_H'
+    source = os.path.relpath(path, os.path.join(os.path.dirname(__file__), '..'))
+    print('#ifndef %s' % guard)
+    print('#define %s' % guard)
+    print()
+    print()
+    print('/* Generated by tools/make_font.py from %s, do not edit.' % source)
+    print('   %d glyphs of %d*%d, %d bytes compressed, %d bytes raw. */' %
+          (len(glyphs), width, height, len(data) + 2 * len(offsets),
+           len(glyphs) * ((width + 7) // 8) * height))
+    print()
+    print()
+    print('#include "font.h"')
+    print()
+    print()
+    print('static const unsigned short %sOffsets_Font[%d] PROGMEM = {' % (name, len(offsets)))
+    print('  ' + ', '.join(str(offset) for offset in offsets) + '};')
+    print()
+    print('static const byte %sData_Font[%d] PROGMEM = {' % (name, len(data)))
+    for (label, rows), start, end in zip(glyphs, offsets, offsets[1:] + [len(data)]):
+        print('  ' + ', '.join('0x%02X' % value for value in data[start:end]) + ', // ' + label)
+    print('};')
+    print()
+    print('static const Font_Font %s_Font = {%d, %d, %d, %sOffsets_Font, %sData_Font};' %
+          (name, width, height, len(glyphs), name, name))
+    print()
+    print('#endif')
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,75 @@
+#!/usr/bin/env python3
+"""Build the Unicode to GB2312 table of main/gb2312.h for the characters in use.
+
+Usage: make_gb2312.py <text.txt> [more.txt ...] > main/gb2312_table.h
+
+Input: UTF-8 text, '#' lines are comments. Every character above U+007F
+is put into the table once, ASCII is shown by the half width ROM font and
+needs no entry. Characters GB2312 has no code for stop the build.
+
+The table is two PROGMEM arrays sorted by code point, so that the display
+code finds a character by binary search. Each entry takes 4 bytes of flash.
+"""
+
+import os
+import sys
+
+
+def read_characters(paths):
+    characters = set()
+    for path in paths:
+        with open(path, encoding='utf-8') as file:
+            for line in file:
+                if line.startswith('#'):
+                    continue
+                characters.update(c for c in line if ord(c) > 0x7F)
+    return sorted(characters)
+
+
+def main():
+    if len(sys.argv) < 2:
+        sys.exit(__doc__)
+    paths = sys.argv[1:]
+    entries = []
+    for character in read_characters(paths):
+        if ord(character) > 0xFFFF:
+            sys.exit('U+%X is outside the basic multilingual plane' % ord(character))
+        try:
+            code = character.encode('gb2312')
+        except UnicodeEncodeError:
+            sys.exit('%s (U+%04X) has no GB2312 code' % (character, ord(character)))
+        entries.append((ord(character), code[0] << 8 | code[1], character))
+
+    root = os.path.join(os.path.dirname(__file__), '..')
+    sources = ', '.join(os.path.relpath(path, root) for path in paths)
+    print('#ifndef GB2312_TABLE_H')
+    print('#define GB2312_TABLE_H')
+    print()
+    print()
+    print('/* Generated by tools/make_gb2312.py from %s, do not edit.' % sources)
+    print('   %d characters, %d bytes. */' % (len(entries), 4 * len(entries)))
+    print()
+    print()
+    print('#include <Arduino.h>')
+    print()
+    print('#define ENTRIES_GB2312 %d' % len(entries))
+    print()
+    print('// Sorted, so that unicodes_GB2312[i] is shown by codes_GB2312[i].')
+    print('static const unsigned short unicodes_GB2312[ENTRIES_GB2312] PROGMEM = {')
+    for start in range(0, len(entries), 8):
+        row = entries[start:start + 8]
+        print('  ' + ', '.join('0x%04X' % entry[0] for entry in row) + ', // ' +
+              ''.join(entry[2] for entry in row))
+    print('};')
+    print()
+    print('static const unsigned short codes_GB2312[ENTRIES_GB2312] PROGMEM = {')
+    for start in range(0, len(entries), 8):
+        row = entries[start:start + 8]
+        print('  ' + ', '.join('0x%04X' % entry[1] for entry in row) + ',')
+    print('};')
+    print()
+    print('#endif')
+
+
+if __name__ == '__main__':
+    main()